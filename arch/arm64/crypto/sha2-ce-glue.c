@@ -37,6 +37,10 @@ static inline void __cfi_sha2_ce_transform(struct sha256_state *sst,
 #define sha2_ce_transform __cfi_sha2_ce_transform
 #endif
 
+asmlinkage void sha2_ce_transform2x(u32 *state_a, u32 *state_b,
+				    u8 const *src_a, u8 const *src_b,
+				    int blocks);
+
 const u32 sha256_ce_offsetof_count = offsetof(struct sha256_ce_state,
 					      sst.count);
 const u32 sha256_ce_offsetof_finalize = offsetof(struct sha256_ce_state,
@@ -89,11 +93,81 @@ static int sha256_ce_final(struct shash_desc *desc, u8 *out)
 	return sha256_base_finish(desc, out);
 }
 
+/*
+ * Finish two messages of the same length, both starting from the state in
+ * @desc. The buffered partial block and the padding are put together here,
+ * so that the asm only ever runs whole blocks of both messages side by side.
+ */
+static int sha256_ce_finup_mb(struct shash_desc *desc, const u8 * const data[],
+			      unsigned int len, u8 * const outs[],
+			      unsigned int num_msgs)
+{
+	struct sha256_ce_state *sctx = shash_desc_ctx(desc);
+	unsigned int digest_size = crypto_shash_digestsize(desc->tfm);
+	unsigned int partial = sctx->sst.count % SHA256_BLOCK_SIZE;
+	u64 bits = (sctx->sst.count + len) << 3;
+	u8 buf[2][2 * SHA256_BLOCK_SIZE];
+	u32 state[2][SHA256_DIGEST_SIZE / sizeof(u32)];
+	unsigned int fill = 0, done = 0, blocks, tail, i, j;
+
+	memcpy(state[0], sctx->sst.state, sizeof(state[0]));
+	memcpy(state[1], sctx->sst.state, sizeof(state[1]));
+
+	kernel_neon_begin();
+
+	if (partial) {
+		done = min(len, SHA256_BLOCK_SIZE - partial);
+		for (i = 0; i < num_msgs; i++) {
+			memcpy(buf[i], sctx->sst.buf, partial);
+			memcpy(buf[i] + partial, data[i], done);
+		}
+		fill = partial + done;
+		if (fill == SHA256_BLOCK_SIZE) {
+			sha2_ce_transform2x(state[0], state[1], buf[0], buf[1],
+					    1);
+			fill = 0;
+		}
+	}
+
+	blocks = (len - done) / SHA256_BLOCK_SIZE;
+	if (blocks) {
+		sha2_ce_transform2x(state[0], state[1], data[0] + done,
+				    data[1] + done, blocks);
+		done += blocks * SHA256_BLOCK_SIZE;
+	}
+
+	/* Only the final block(s) left: the rest of the data and padding */
+	tail = fill + (len - done) + 1 + sizeof(__be64) > SHA256_BLOCK_SIZE ?
+	       2 * SHA256_BLOCK_SIZE : SHA256_BLOCK_SIZE;
+	for (i = 0; i < num_msgs; i++) {
+		memcpy(buf[i] + fill, data[i] + done, len - done);
+		buf[i][fill + len - done] = 0x80;
+		memset(buf[i] + fill + len - done + 1, 0,
+		       tail - (fill + len - done + 1) - sizeof(__be64));
+		put_unaligned_be64(bits, buf[i] + tail - sizeof(__be64));
+	}
+	sha2_ce_transform2x(state[0], state[1], buf[0], buf[1],
+			    tail / SHA256_BLOCK_SIZE);
+
+	kernel_neon_end();
+
+	for (i = 0; i < num_msgs; i++)
+		for (j = 0; j < digest_size / sizeof(u32); j++)
+			put_unaligned_be32(state[i][j],
+					   outs[i] + j * sizeof(u32));
+
+	memzero_explicit(buf, sizeof(buf));
+	*sctx = (struct sha256_ce_state){};
+	return 0;
+}
+
 static struct shash_alg algs[] = { {
 	.init			= sha224_base_init,
 	.update			= sha256_ce_update,
 	.final			= sha256_ce_final,
 	.finup			= sha256_ce_finup,
+	.finup_mb		= sha256_ce_finup_mb,
+	.mb_max_msgs		= 2,
 	.descsize		= sizeof(struct sha256_ce_state),
 	.digestsize		= SHA224_DIGEST_SIZE,
 	.base			= {
@@ -109,6 +183,8 @@ static struct shash_alg algs[] = { {
 	.update			= sha256_ce_update,
 	.final			= sha256_ce_final,
 	.finup			= sha256_ce_finup,
+	.finup_mb		= sha256_ce_finup_mb,
+	.mb_max_msgs		= 2,
 	.descsize		= sizeof(struct sha256_ce_state),
 	.digestsize		= SHA256_DIGEST_SIZE,
 	.base			= {
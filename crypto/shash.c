@@ -182,6 +182,31 @@ int crypto_shash_finup(struct shash_desc *desc, const u8 *data,
 }
 EXPORT_SYMBOL_GPL(crypto_shash_finup);
 
+int crypto_shash_finup_mb(struct shash_desc *desc, const u8 * const data[],
+			  unsigned int len, u8 * const outs[],
+			  unsigned int num_msgs)
+{
+	struct crypto_shash *tfm = desc->tfm;
+	struct shash_alg *shash = crypto_shash_alg(tfm);
+	unsigned long alignmask = crypto_shash_alignmask(tfm);
+	unsigned int i;
+
+	if (num_msgs == 1)
+		return crypto_shash_finup(desc, data[0], len, outs[0]);
+
+	if (WARN_ON_ONCE(num_msgs > shash->mb_max_msgs))
+		return -EINVAL;
+
+	for (i = 0; i < num_msgs; i++) {
+		if (((unsigned long)data[i] | (unsigned long)outs[i]) &
+		    alignmask)
+			return -EINVAL;
+	}
+
+	return shash->finup_mb(desc, data, len, outs, num_msgs);
+}
+EXPORT_SYMBOL_GPL(crypto_shash_finup_mb);
+
 static int shash_digest_unaligned(struct shash_desc *desc, const u8 *data,
 				  unsigned int len, u8 *out)
 {
@@ -485,6 +510,11 @@ static int shash_prepare_alg(struct shash_alg *alg)
 	}
 	if (!alg->setkey)
 		alg->setkey = shash_no_setkey;
+	if (!alg->finup_mb)
+		alg->mb_max_msgs = 1;
+	else if (alg->mb_max_msgs < 2)
+		return -EINVAL;
+	alg->mb_tested = false;
 
 	return 0;
 }
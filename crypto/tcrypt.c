@@ -772,6 +772,154 @@ static void test_hash_speed(const char *algo, unsigned int secs,
 	return test_ahash_speed_common(algo, secs, speed, CRYPTO_ALG_ASYNC);
 }
 
+static int test_shash_mb_op(struct shash_desc *desc, const u8 * const data[],
+			    int blen, u8 * const outs[], unsigned int n)
+{
+	return crypto_shash_init(desc) ?:
+	       crypto_shash_finup_mb(desc, data, blen, outs, n);
+}
+
+static int test_shash_mb_jiffies(struct shash_desc *desc,
+				 const u8 * const data[], int blen,
+				 u8 * const outs[], unsigned int n, int secs)
+{
+	unsigned long start, end;
+	int bcount;
+	int ret;
+
+	for (start = jiffies, end = start + secs * HZ, bcount = 0;
+	     time_before(jiffies, end); bcount++) {
+		ret = test_shash_mb_op(desc, data, blen, outs, n);
+		if (ret)
+			return ret;
+	}
+
+	printk("%6u opers/sec, %9lu bytes/sec\n",
+	       bcount / secs, ((long)bcount * blen * n) / secs);
+
+	return 0;
+}
+
+static int test_shash_mb_cycles(struct shash_desc *desc,
+				const u8 * const data[], int blen,
+				u8 * const outs[], unsigned int n)
+{
+	unsigned long cycles = 0;
+	int i, ret;
+
+	/* Warm-up run. */
+	for (i = 0; i < 4; i++) {
+		ret = test_shash_mb_op(desc, data, blen, outs, n);
+		if (ret)
+			return ret;
+	}
+
+	/* The real thing. */
+	for (i = 0; i < 8; i++) {
+		cycles_t start, end;
+
+		start = get_cycles();
+
+		ret = test_shash_mb_op(desc, data, blen, outs, n);
+		if (ret)
+			return ret;
+
+		end = get_cycles();
+
+		cycles += end - start;
+	}
+
+	pr_cont("%6lu cycles/operation, %4lu cycles/byte\n",
+		cycles / 8, cycles / (8 * blen * n));
+
+	return 0;
+}
+
+/*
+ * Compare hashing one message per crypto_shash_finup_mb() call against as
+ * many as the algorithm takes at once, each message in its own tvmem page.
+ */
+static void test_shash_mb_speed(const char *algo, unsigned int secs,
+				struct hash_speed *speed)
+{
+	const u8 *data[TVMEMSIZE];
+	u8 *outs[TVMEMSIZE];
+	struct crypto_shash *tfm;
+	struct shash_desc *desc;
+	unsigned int max_msgs, n;
+	char *output;
+	int i, ret;
+
+	tfm = crypto_alloc_shash(algo, 0, 0);
+	if (IS_ERR(tfm)) {
+		pr_err("failed to load transform for %s: %ld\n",
+		       algo, PTR_ERR(tfm));
+		return;
+	}
+
+	printk(KERN_INFO "\ntesting speed of multibuffer %s (%s)\n", algo,
+			get_driver_name(crypto_shash, tfm));
+
+	if (crypto_shash_digestsize(tfm) > MAX_DIGEST_SIZE) {
+		pr_err("digestsize(%u) > %d\n", crypto_shash_digestsize(tfm),
+		       MAX_DIGEST_SIZE);
+		goto out;
+	}
+
+	desc = kmalloc(sizeof(*desc) + crypto_shash_descsize(tfm),
+		       GFP_KERNEL);
+	if (!desc)
+		goto out;
+	desc->tfm = tfm;
+	desc->flags = 0;
+
+	max_msgs = min_t(unsigned int, crypto_shash_mb_max_msgs(tfm),
+			 TVMEMSIZE);
+	output = kmalloc(max_msgs * MAX_DIGEST_SIZE, GFP_KERNEL);
+	if (!output)
+		goto out_nomem;
+
+	for (n = 0; n < max_msgs; n++) {
+		data[n] = tvmem[n];
+		outs[n] = output + n * MAX_DIGEST_SIZE;
+	}
+
+	for (i = 0; speed[i].blen != 0; i++) {
+		/* Only whole messages, each fitting in one page */
+		if (speed[i].blen != speed[i].plen ||
+		    speed[i].blen > PAGE_SIZE)
+			continue;
+
+		for (n = 1; n <= max_msgs; n++) {
+			pr_info("test%3u (%5u byte blocks,%2u messages): ",
+				i, speed[i].blen, n);
+
+			if (secs)
+				ret = test_shash_mb_jiffies(desc, data,
+							    speed[i].blen,
+							    outs, n, secs);
+			else
+				ret = test_shash_mb_cycles(desc, data,
+							   speed[i].blen,
+							   outs, n);
+
+			if (ret) {
+				pr_err("hashing failed ret=%d\n", ret);
+				goto out_free;
+			}
+		}
+	}
+
+out_free:
+	kfree(output);
+
+out_nomem:
+	kfree(desc);
+
+out:
+	crypto_free_shash(tfm);
+}
+
 static inline int do_one_acipher_op(struct skcipher_request *req, int ret)
 {
 	if (ret == -EINPROGRESS || ret == -EBUSY) {
@@ -1729,6 +1877,10 @@ static int do_test(const char *alg, u32 type, u32 mask, int m)
 		test_hash_speed("sha3-512", sec, generic_hash_speed_template);
 		if (mode > 300 && mode < 400) break;
 
+	case 326:
+		test_shash_mb_speed("sha256", sec, generic_hash_speed_template);
+		if (mode > 300 && mode < 400) break;
+
 	case 399:
 		break;
 
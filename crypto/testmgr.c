@@ -1612,6 +1612,127 @@ static int alg_test_comp(const struct alg_test_desc *desc, const char *driver,
 	return err;
 }
 
+/* Common prefix and message lengths the finup_mb self-test is run with */
+static const struct {
+	unsigned int prefix_len;
+	unsigned int len;
+} finup_mb_tests[] = {
+	{ 0, 0 }, { 0, 1 }, { 0, 55 }, { 0, 56 }, { 0, 64 }, { 1, 63 },
+	{ 3, 120 }, { 32, 4096 }, { 63, 2 }, { 64, 4096 }, { 100, 1000 },
+};
+
+#define FINUP_MB_MAX_MSGS	8
+#define FINUP_MB_MAX_PREFIX	100
+#define FINUP_MB_MAX_LEN	4096
+#define FINUP_MB_MAX_DIGEST	64
+
+/*
+ * Check ->finup_mb against one crypto_shash_finup() per message, for every
+ * number of messages the algorithm takes. The messages differ in every
+ * byte. Only once this passes does crypto_shash_mb_max_msgs() report more
+ * than one message; a broken ->finup_mb alone doesn't fail the algorithm,
+ * whose other operations have already been tested.
+ */
+static int test_shash_finup_mb(const char *driver, u32 type, u32 mask)
+{
+	struct crypto_shash *tfm;
+	struct shash_alg *alg;
+	u8 *buf, *prefix, *out;
+	const u8 *data[FINUP_MB_MAX_MSGS];
+	u8 *outs[FINUP_MB_MAX_MSGS];
+	unsigned int digestsize, i, j, n;
+	int err = 0;
+
+	tfm = crypto_alloc_shash(driver, type | CRYPTO_ALG_INTERNAL, mask);
+	if (IS_ERR(tfm)) {
+		pr_err("alg: hash: Failed to load shash transform for %s: %ld\n",
+		       driver, PTR_ERR(tfm));
+		return PTR_ERR(tfm);
+	}
+
+	alg = crypto_shash_alg(tfm);
+	digestsize = crypto_shash_digestsize(tfm);
+	if (!alg->finup_mb)
+		goto out_free_tfm;
+	if (alg->mb_max_msgs > FINUP_MB_MAX_MSGS ||
+	    digestsize > FINUP_MB_MAX_DIGEST) {
+		pr_warn("alg: hash: Can't self-test finup_mb of %s\n", driver);
+		goto out_free_tfm;
+	}
+
+	buf = kmalloc(FINUP_MB_MAX_PREFIX +
+		      alg->mb_max_msgs * FINUP_MB_MAX_LEN +
+		      2 * alg->mb_max_msgs * FINUP_MB_MAX_DIGEST, GFP_KERNEL);
+	if (!buf) {
+		err = -ENOMEM;
+		goto out_free_tfm;
+	}
+
+	prefix = buf;
+	for (i = 0; i < FINUP_MB_MAX_PREFIX; i++)
+		prefix[i] = i * 13 + 5;
+	for (n = 0; n < alg->mb_max_msgs; n++) {
+		u8 *msg = buf + FINUP_MB_MAX_PREFIX + n * FINUP_MB_MAX_LEN;
+
+		for (i = 0; i < FINUP_MB_MAX_LEN; i++)
+			msg[i] = i * 31 + n * 7 + 1;
+		data[n] = msg;
+	}
+	out = buf + FINUP_MB_MAX_PREFIX + alg->mb_max_msgs * FINUP_MB_MAX_LEN;
+	for (n = 0; n < alg->mb_max_msgs; n++)
+		outs[n] = out + n * FINUP_MB_MAX_DIGEST;
+	out += alg->mb_max_msgs * FINUP_MB_MAX_DIGEST;
+
+	for (i = 0; i < ARRAY_SIZE(finup_mb_tests); i++) {
+		unsigned int prefix_len = finup_mb_tests[i].prefix_len;
+		unsigned int len = finup_mb_tests[i].len;
+
+		for (n = 2; n <= alg->mb_max_msgs; n++) {
+			SHASH_DESC_ON_STACK(desc, tfm);
+
+			desc->tfm = tfm;
+			desc->flags = 0;
+
+			err = crypto_shash_init(desc) ?:
+			      crypto_shash_update(desc, prefix, prefix_len) ?:
+			      crypto_shash_finup_mb(desc, data, len, outs, n);
+			if (err) {
+				pr_err("alg: hash: finup_mb failed on test %u for %s: %d, not using it\n",
+				       i + 1, driver, err);
+				err = 0;
+				goto out_free_buf;
+			}
+
+			for (j = 0; j < n; j++) {
+				err = crypto_shash_init(desc) ?:
+				      crypto_shash_update(desc, prefix,
+							  prefix_len) ?:
+				      crypto_shash_finup(desc, data[j], len,
+							 out);
+				if (err) {
+					pr_err("alg: hash: finup failed on test %u for %s: %d\n",
+					       i + 1, driver, err);
+					goto out_free_buf;
+				}
+
+				if (memcmp(outs[j], out, digestsize)) {
+					pr_err("alg: hash: finup_mb test %u failed for %s: message %u of %u, not using it\n",
+					       i + 1, driver, j + 1, n);
+					goto out_free_buf;
+				}
+			}
+		}
+	}
+
+	alg->mb_tested = true;
+
+out_free_buf:
+	kfree(buf);
+out_free_tfm:
+	crypto_free_shash(tfm);
+	return err;
+}
+
 static int alg_test_hash(const struct alg_test_desc *desc, const char *driver,
 			 u32 type, u32 mask)
 {
@@ -1631,6 +1752,10 @@ static int alg_test_hash(const struct alg_test_desc *desc, const char *driver,
 		err = test_hash(tfm, desc->suite.hash.vecs,
 				desc->suite.hash.count, false);
 
+	if (!err && (crypto_ahash_tfm(tfm)->__crt_alg->cra_flags &
+		     CRYPTO_ALG_TYPE_MASK) == CRYPTO_ALG_TYPE_SHASH)
+		err = test_shash_finup_mb(driver, type, mask);
+
 	crypto_free_ahash(tfm);
 	return err;
 }
@@ -0,0 +1,298 @@
+/*
+ * Compressed RAM block device - deduplication of identical pages
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+
+#include <linux/highmem.h>
+#include <linux/log2.h>
+#include <linux/rbtree.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/xxhash.h>
+
+#include "zram_drv.h"
+
+/* One hash bucket per 2^ZRAM_HASH_SHIFT pages of disksize */
+#define ZRAM_HASH_SHIFT		10
+#define ZRAM_HASH_SIZE_MIN	(1 << 10)
+#define ZRAM_HASH_SIZE_MAX	(1 << 30)
+
+static u32 zram_dedup_checksum(unsigned char *mem)
+{
+	return xxh32(mem, PAGE_SIZE, 0);
+}
+
+static struct zram_hash *zram_dedup_bucket(struct zram *zram, u32 checksum)
+{
+	return &zram->hash[checksum & (zram->hash_size - 1)];
+}
+
+static void zram_dedup_insert(struct zram *zram, struct zram_entry *new)
+{
+	struct zram_hash *hash = zram_dedup_bucket(zram, new->checksum);
+	struct rb_node **rb_node, *parent = NULL;
+	struct zram_entry *entry;
+
+	spin_lock(&hash->lock);
+	rb_node = &hash->rb_root.rb_node;
+	while (*rb_node) {
+		parent = *rb_node;
+		entry = rb_entry(parent, struct zram_entry, rb_node);
+		if (new->checksum < entry->checksum)
+			rb_node = &parent->rb_left;
+		else
+			rb_node = &parent->rb_right;
+	}
+
+	rb_link_node(&new->rb_node, parent, rb_node);
+	rb_insert_color(&new->rb_node, &hash->rb_root);
+	spin_unlock(&hash->lock);
+}
+
+static bool zram_dedup_match(struct zram *zram, struct zram_entry *entry,
+				unsigned char *mem)
+{
+	bool match = false;
+	unsigned char *cmem;
+	struct zcomp_strm *zstrm;
+
+	cmem = zs_map_object(zram->mem_pool, entry->handle, ZS_MM_RO);
+	if (entry->len == PAGE_SIZE) {
+		match = !memcmp(mem, cmem, PAGE_SIZE);
+	} else {
+		zstrm = zcomp_stream_get(zram->comp);
+		if (!zcomp_decompress(zstrm, cmem, entry->len, zstrm->buffer))
+			match = !memcmp(mem, zstrm->buffer, PAGE_SIZE);
+		zcomp_stream_put(zram->comp);
+	}
+	zs_unmap_object(zram->mem_pool, entry->handle);
+
+	return match;
+}
+
+/*
+ * Take a reference to the first entry with @checksum, or to the one after
+ * @prev if it has the same checksum. Returns NULL when there is none left.
+ */
+static struct zram_entry *zram_dedup_get(struct zram_hash *hash,
+				struct zram_entry *prev, u32 checksum)
+{
+	struct zram_entry *entry = NULL;
+	struct rb_node *rb_node;
+
+	spin_lock(&hash->lock);
+	if (prev) {
+		/* prev is referenced, so it is still in the tree */
+		rb_node = rb_next(&prev->rb_node);
+	} else {
+		rb_node = hash->rb_root.rb_node;
+		while (rb_node) {
+			struct zram_entry *cur = rb_entry(rb_node,
+						struct zram_entry, rb_node);
+
+			if (checksum == cur->checksum)
+				break;
+
+			rb_node = checksum < cur->checksum ?
+					rb_node->rb_left : rb_node->rb_right;
+		}
+
+		/* equal checksums are adjacent, start from the first one */
+		while (rb_node) {
+			struct rb_node *prev_node = rb_prev(rb_node);
+
+			if (!prev_node || rb_entry(prev_node, struct zram_entry,
+						rb_node)->checksum != checksum)
+				break;
+			rb_node = prev_node;
+		}
+	}
+
+	if (rb_node) {
+		entry = rb_entry(rb_node, struct zram_entry, rb_node);
+		if (entry->checksum == checksum)
+			entry->refcount++;
+		else
+			entry = NULL;
+	}
+	spin_unlock(&hash->lock);
+
+	return entry;
+}
+
+/*
+ * Turn a lookup reference into a slot user once the content matched.
+ * Only users count towards dup_data_size, so a candidate that turns out
+ * to be a checksum collision never shows up there.
+ */
+static void zram_dedup_claim(struct zram *zram, struct zram_hash *hash,
+				struct zram_entry *entry)
+{
+	unsigned long users;
+
+	spin_lock(&hash->lock);
+	users = ++entry->users;
+	spin_unlock(&hash->lock);
+
+	if (users > 1)
+		atomic64_add(entry->len, &zram->stats.dup_data_size);
+}
+
+/*
+ * Drop a reference taken by zram_dedup_get(), or by a slot user if @user
+ * is set. The last reference frees the object.
+ */
+static void zram_dedup_release(struct zram *zram, struct zram_entry *entry,
+				bool user)
+{
+	struct zram_hash *hash = zram_dedup_bucket(zram, entry->checksum);
+	unsigned long refcount, users;
+
+	spin_lock(&hash->lock);
+	if (user)
+		entry->users--;
+	users = entry->users;
+	refcount = --entry->refcount;
+	if (!refcount)
+		rb_erase(&entry->rb_node, &hash->rb_root);
+	spin_unlock(&hash->lock);
+
+	if (user && users)
+		atomic64_sub(entry->len, &zram->stats.dup_data_size);
+
+	if (refcount)
+		return;
+
+	zs_free(zram->mem_pool, entry->handle);
+	atomic64_sub(entry->len, &zram->stats.compr_data_size);
+	atomic64_sub(sizeof(*entry), &zram->stats.meta_data_size);
+	kfree(entry);
+}
+
+/*
+ * Look up a stored object with the same content as @page. On success a
+ * reference to the entry is returned. Otherwise NULL is returned and
+ * @checksum is set for a later zram_dedup_new().
+ */
+struct zram_entry *zram_dedup_find(struct zram *zram, struct page *page,
+				u32 *checksum)
+{
+	struct zram_hash *hash;
+	struct zram_entry *entry, *next;
+	unsigned char *mem;
+	u32 sum;
+
+	if (!zram->hash)
+		return NULL;
+
+	mem = kmap_atomic(page);
+	sum = zram_dedup_checksum(mem);
+	*checksum = sum;
+
+	hash = zram_dedup_bucket(zram, sum);
+	entry = zram_dedup_get(hash, NULL, sum);
+	while (entry) {
+		/* A reference is held, so the handle can't go away under us */
+		if (zram_dedup_match(zram, entry, mem)) {
+			zram_dedup_claim(zram, hash, entry);
+			break;
+		}
+
+		/* checksum collision, try the other entries with this sum */
+		next = zram_dedup_get(hash, entry, sum);
+		zram_dedup_release(zram, entry, false);
+		entry = next;
+	}
+
+	kunmap_atomic(mem);
+	return entry;
+}
+
+/*
+ * Wrap a freshly written object in a dedup entry so that later writes
+ * of the same content can share it. Returns NULL if deduplication is
+ * off or the entry can't be allocated, in which case the caller keeps
+ * the plain handle.
+ */
+struct zram_entry *zram_dedup_new(struct zram *zram, unsigned long handle,
+				unsigned int len, u32 checksum)
+{
+	struct zram_entry *entry;
+
+	if (!zram->hash)
+		return NULL;
+
+	entry = kmalloc(sizeof(*entry), GFP_NOIO | __GFP_NOWARN);
+	if (!entry)
+		return NULL;
+
+	entry->handle = handle;
+	entry->len = len;
+	entry->checksum = checksum;
+	entry->refcount = 1;
+	entry->users = 1;
+	RB_CLEAR_NODE(&entry->rb_node);
+
+	zram_dedup_insert(zram, entry);
+	atomic64_add(sizeof(*entry), &zram->stats.meta_data_size);
+
+	return entry;
+}
+
+void zram_dedup_put(struct zram *zram, struct zram_entry *entry)
+{
+	zram_dedup_release(zram, entry, true);
+}
+
+/*
+ * Called with the slot lock of one of the entry's users held. The entry
+ * can still gain users once the hash lock is dropped, so the answer is
+ * only a hint.
+ */
+bool zram_dedup_shared(struct zram *zram, struct zram_entry *entry)
+{
+	struct zram_hash *hash = zram_dedup_bucket(zram, entry->checksum);
+	bool shared;
+
+	spin_lock(&hash->lock);
+	shared = entry->users > 1;
+	spin_unlock(&hash->lock);
+
+	return shared;
+}
+
+int zram_dedup_init(struct zram *zram, size_t num_pages)
+{
+	size_t i;
+
+	if (!zram->use_dedup)
+		return 0;
+
+	zram->hash_size = num_pages >> ZRAM_HASH_SHIFT;
+	zram->hash_size = clamp_t(size_t, zram->hash_size,
+				ZRAM_HASH_SIZE_MIN, ZRAM_HASH_SIZE_MAX);
+	zram->hash_size = rounddown_pow_of_two(zram->hash_size);
+	zram->hash = vzalloc(zram->hash_size * sizeof(struct zram_hash));
+	if (!zram->hash)
+		return -ENOMEM;
+
+	for (i = 0; i < zram->hash_size; i++) {
+		spin_lock_init(&zram->hash[i].lock);
+		zram->hash[i].rb_root = RB_ROOT;
+	}
+
+	atomic64_add(zram->hash_size * sizeof(struct zram_hash),
+			&zram->stats.meta_data_size);
+	return 0;
+}
+
+void zram_dedup_fini(struct zram *zram)
+{
+	vfree(zram->hash);
+	zram->hash = NULL;
+	zram->hash_size = 0;
+}
@@ -53,6 +53,8 @@ static size_t huge_class_size;
 static void zram_free_page(struct zram *zram, size_t index);
 static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
 				u32 index, int offset, struct bio *bio);
+static int zram_read_from_zspool(struct zram *zram, struct page *page,
+				u32 index);
 
 
 static int zram_slot_trylock(struct zram *zram, u32 index)
@@ -80,16 +82,6 @@ static inline struct zram *dev_to_zram(struct device *dev)
 	return (struct zram *)dev_to_disk(dev)->private_data;
 }
 
-static unsigned long zram_get_handle(struct zram *zram, u32 index)
-{
-	return zram->table[index].handle;
-}
-
-static void zram_set_handle(struct zram *zram, u32 index, unsigned long handle)
-{
-	zram->table[index].handle = handle;
-}
-
 /* flag operations require table entry bit_spin_lock() being held */
 static bool zram_test_flag(struct zram *zram, u32 index,
 			enum zram_pageflags flag)
@@ -109,6 +101,40 @@ static void zram_clear_flag(struct zram *zram, u32 index,
 	zram->table[index].flags &= ~BIT(flag);
 }
 
+static struct zcomp *zram_slot_comp(struct zram *zram, u32 index)
+{
+#ifdef CONFIG_ZRAM_RECOMPRESS
+	if (zram_test_flag(zram, index, ZRAM_RECOMP))
+		return zram->recomp;
+#endif
+	return zram->comp;
+}
+
+static unsigned long zram_get_handle(struct zram *zram, u32 index)
+{
+	if (zram_test_flag(zram, index, ZRAM_DEDUP))
+		return zram->table[index].entry->handle;
+
+	return zram->table[index].handle;
+}
+
+static void zram_set_handle(struct zram *zram, u32 index, unsigned long handle)
+{
+	zram->table[index].handle = handle;
+}
+
+static struct zram_entry *zram_get_entry(struct zram *zram, u32 index)
+{
+	return zram->table[index].entry;
+}
+
+static void zram_set_entry(struct zram *zram, u32 index,
+			struct zram_entry *entry)
+{
+	zram->table[index].entry = entry;
+	zram_set_flag(zram, index, ZRAM_DEDUP);
+}
+
 static inline void zram_set_element(struct zram *zram, u32 index,
 			unsigned long element)
 {
@@ -561,14 +587,24 @@ static ssize_t backing_dev_store(struct device *dev,
 	return err;
 }
 
-static unsigned long alloc_block_bdev(struct zram *zram)
+/*
+ * Allocate a block on the backing device, preferring @hint so that pages
+ * written back together end up contiguous on the device.
+ */
+static unsigned long alloc_block_bdev(struct zram *zram, unsigned long hint)
 {
-	unsigned long blk_idx = 1;
-retry:
 	/* skip 0 bit to confuse zram.handle = 0 */
+	unsigned long blk_idx = max(hint, 1UL);
+	bool wrapped = false;
+retry:
 	blk_idx = find_next_zero_bit(zram->bitmap, zram->nr_pages, blk_idx);
-	if (blk_idx == zram->nr_pages)
-		return 0;
+	if (blk_idx == zram->nr_pages) {
+		if (wrapped)
+			return 0;
+		wrapped = true;
+		blk_idx = 1;
+		goto retry;
+	}
 
 	if (test_and_set_bit(blk_idx, zram->bitmap))
 		goto retry;
@@ -586,11 +622,33 @@ static void free_block_bdev(struct zram *zram, unsigned long blk_idx)
 	atomic64_dec(&zram->stats.bd_count);
 }
 
+/* Tracks a backing device read so its fault-in latency can be reported */
+struct zram_bd_read {
+	struct zram *zram;
+	struct bio *parent;
+	ktime_t start;
+};
+
 static void zram_page_end_io(struct bio *bio)
 {
-	struct page *page = bio->bi_io_vec[0].bv_page;
+	struct zram_bd_read *rd = bio->bi_private;
+	struct bio *parent = rd->parent;
+
+	atomic64_add(ktime_us_delta(ktime_get(), rd->start),
+			&rd->zram->stats.bd_read_time_us);
+	kfree(rd);
+
+	if (parent) {
+		/* what bio_chain() would do, see __bio_chain_endio() */
+		if (!parent->bi_error)
+			parent->bi_error = bio->bi_error;
+		bio_put(bio);
+		bio_endio(parent);
+		return;
+	}
 
-	page_endio(page, op_is_write(bio_op(bio)), bio->bi_error);
+	page_endio(bio->bi_io_vec[0].bv_page, op_is_write(bio_op(bio)),
+			bio->bi_error);
 	bio_put(bio);
 }
 
@@ -600,26 +658,39 @@ static void zram_page_end_io(struct bio *bio)
 static int read_from_bdev_async(struct zram *zram, struct bio_vec *bvec,
 			unsigned long entry, struct bio *parent)
 {
+	struct zram_bd_read *rd;
 	struct bio *bio;
 
+	rd = kmalloc(sizeof(*rd), GFP_ATOMIC);
+	if (!rd)
+		return -ENOMEM;
+
 	bio = bio_alloc(GFP_ATOMIC, 1);
-	if (!bio)
+	if (!bio) {
+		kfree(rd);
 		return -ENOMEM;
+	}
 
 	bio->bi_iter.bi_sector = entry * (PAGE_SIZE >> 9);
 	bio->bi_bdev = zram->bdev;
 	if (!bio_add_page(bio, bvec->bv_page, bvec->bv_len, bvec->bv_offset)) {
 		bio_put(bio);
+		kfree(rd);
 		return -EIO;
 	}
 
+	rd->zram = zram;
+	rd->parent = parent;
+	rd->start = ktime_get();
+
 	if (!parent) {
 		bio->bi_opf = REQ_OP_READ;
-		bio->bi_end_io = zram_page_end_io;
 	} else {
 		bio->bi_opf = parent->bi_opf;
-		bio_chain(bio, parent);
+		bio_inc_remaining(parent);
 	}
+	bio->bi_end_io = zram_page_end_io;
+	bio->bi_private = rd;
 
 	submit_bio(bio);
 	return 1;
@@ -628,18 +699,248 @@ static int read_from_bdev_async(struct zram *zram, struct bio_vec *bvec,
 #define HUGE_WRITEBACK 1
 #define IDLE_WRITEBACK 2
 
+/* Pages gathered into one writeback batch */
+#define ZRAM_WB_BATCH_PAGES	32
+/* Batches allowed in flight at once */
+#define ZRAM_WB_MAX_INFLIGHT	4
+
+struct zram_wb_batch {
+	struct zram *zram;
+	atomic_t pending;	/* bios in flight plus one for submitter */
+	struct completion done;
+	int error;		/* I/O error */
+	unsigned int nr_pages;
+	unsigned int nr_submitted;	/* pages that got a block */
+	u32 index[ZRAM_WB_BATCH_PAGES];
+	unsigned long blk_idx[ZRAM_WB_BATCH_PAGES];
+	unsigned int reserved[ZRAM_WB_BATCH_PAGES];	/* of bd_wb_limit */
+	struct page *pages[ZRAM_WB_BATCH_PAGES];
+};
+
+/*
+ * Take one page worth of the writeback limit. *@reserved is set to what
+ * was actually taken, which is less than a page at the end of the limit.
+ */
+static bool zram_wb_limit_reserve(struct zram *zram, unsigned int *reserved)
+{
+	bool ret = true;
+
+	*reserved = 0;
+	spin_lock(&zram->wb_limit_lock);
+	if (zram->wb_limit_enable) {
+		if (!zram->bd_wb_limit) {
+			ret = false;
+		} else {
+			*reserved = min_t(u64, zram->bd_wb_limit,
+						1UL << (PAGE_SHIFT - 12));
+			zram->bd_wb_limit -= *reserved;
+		}
+	}
+	spin_unlock(&zram->wb_limit_lock);
+
+	return ret;
+}
+
+static void zram_wb_limit_refund(struct zram *zram, unsigned int reserved)
+{
+	if (!reserved)
+		return;
+
+	spin_lock(&zram->wb_limit_lock);
+	if (zram->wb_limit_enable)
+		zram->bd_wb_limit += reserved;
+	spin_unlock(&zram->wb_limit_lock);
+}
+
+static void zram_wb_batch_put(struct zram_wb_batch *batch)
+{
+	if (atomic_dec_and_test(&batch->pending))
+		complete(&batch->done);
+}
+
+static void zram_wb_end_io(struct bio *bio)
+{
+	struct zram_wb_batch *batch = bio->bi_private;
+
+	if (bio->bi_error)
+		batch->error = bio->bi_error;
+	bio_put(bio);
+	zram_wb_batch_put(batch);
+}
+
+/*
+ * Write the batch out, one bio per run of contiguous blocks. Blocks are
+ * allocated sequentially, so normally the whole batch goes in one bio.
+ */
+static void zram_wb_batch_submit(struct zram_wb_batch *batch,
+				unsigned long *hint)
+{
+	struct zram *zram = batch->zram;
+	struct bio *bio = NULL;
+	unsigned int i;
+
+	atomic_set(&batch->pending, 1);
+	reinit_completion(&batch->done);
+	batch->error = 0;
+
+	for (i = 0; i < batch->nr_pages; i++) {
+		unsigned long blk_idx = alloc_block_bdev(zram, *hint);
+
+		/* Leave the rest of the batch in memory */
+		if (!blk_idx)
+			break;
+		batch->blk_idx[i] = blk_idx;
+		*hint = blk_idx + 1;
+
+		if (bio && (blk_idx != batch->blk_idx[i - 1] + 1 ||
+				!bio_add_page(bio, batch->pages[i],
+						PAGE_SIZE, 0))) {
+			submit_bio(bio);
+			bio = NULL;
+		}
+
+		if (!bio) {
+			bio = bio_alloc(GFP_KERNEL, batch->nr_pages - i);
+			bio->bi_bdev = zram->bdev;
+			bio->bi_iter.bi_sector = blk_idx * (PAGE_SIZE >> 9);
+			bio_set_op_attrs(bio, REQ_OP_WRITE, 0);
+			bio->bi_end_io = zram_wb_end_io;
+			bio->bi_private = batch;
+			atomic_inc(&batch->pending);
+			atomic64_inc(&zram->stats.bd_wb_bios);
+			bio_add_page(bio, batch->pages[i], PAGE_SIZE, 0);
+		}
+	}
+
+	batch->nr_submitted = i;
+	for (; i < batch->nr_pages; i++)
+		batch->blk_idx[i] = 0;
+
+	if (bio)
+		submit_bio(bio);
+	zram_wb_batch_put(batch);
+}
+
+static void zram_wb_page_abort(struct zram *zram, u32 index,
+				unsigned int reserved)
+{
+	zram_slot_lock(zram, index);
+	zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+	zram_clear_flag(zram, index, ZRAM_IDLE);
+	zram_slot_unlock(zram, index);
+	zram_wb_limit_refund(zram, reserved);
+}
+
+/*
+ * Wait for the batch and switch the written slots over to the bdev. Pages
+ * that got no block are left in memory. Returns -ENOSPC if there were
+ * such pages, otherwise the batch's I/O error.
+ */
+static int zram_wb_batch_finish(struct zram_wb_batch *batch)
+{
+	struct zram *zram = batch->zram;
+	unsigned int i;
+	int ret;
+
+	wait_for_completion(&batch->done);
+
+	for (i = 0; i < batch->nr_pages; i++) {
+		u32 index = batch->index[i];
+		unsigned long blk_idx = batch->blk_idx[i];
+
+		if (i >= batch->nr_submitted || batch->error) {
+			if (blk_idx)
+				free_block_bdev(zram, blk_idx);
+			zram_wb_page_abort(zram, index, batch->reserved[i]);
+			continue;
+		}
+
+		atomic64_inc(&zram->stats.bd_writes);
+		/*
+		 * We released zram_slot_lock so need to check if the slot was
+		 * changed. If there is freeing for the slot, we can catch it
+		 * easily by zram_allocated.
+		 * A subtle case is the slot is freed/reallocated/marked as
+		 * ZRAM_IDLE again. To close the race, idle_store doesn't
+		 * mark ZRAM_IDLE once it found the slot was ZRAM_UNDER_WB.
+		 * Thus, we could close the race by checking ZRAM_IDLE bit.
+		 */
+		zram_slot_lock(zram, index);
+		if (!zram_allocated(zram, index) ||
+			  !zram_test_flag(zram, index, ZRAM_IDLE)) {
+			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+			zram_clear_flag(zram, index, ZRAM_IDLE);
+			zram_slot_unlock(zram, index);
+			free_block_bdev(zram, blk_idx);
+			zram_wb_limit_refund(zram, batch->reserved[i]);
+			continue;
+		}
+
+		zram_free_page(zram, index);
+		zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+		zram_set_flag(zram, index, ZRAM_WB);
+		zram_set_element(zram, index, blk_idx);
+		atomic64_inc(&zram->stats.pages_stored);
+		zram_slot_unlock(zram, index);
+	}
+
+	if (batch->nr_submitted < batch->nr_pages)
+		ret = -ENOSPC;
+	else
+		ret = batch->error;
+	batch->nr_pages = 0;
+	return ret;
+}
+
+static void zram_wb_batches_free(struct zram_wb_batch *batches)
+{
+	int i, j;
+
+	for (i = 0; i < ZRAM_WB_MAX_INFLIGHT; i++) {
+		for (j = 0; j < ZRAM_WB_BATCH_PAGES; j++) {
+			if (batches[i].pages[j])
+				__free_page(batches[i].pages[j]);
+		}
+	}
+	kfree(batches);
+}
+
+static struct zram_wb_batch *zram_wb_batches_alloc(struct zram *zram)
+{
+	struct zram_wb_batch *batches;
+	int i, j;
+
+	batches = kcalloc(ZRAM_WB_MAX_INFLIGHT, sizeof(*batches), GFP_KERNEL);
+	if (!batches)
+		return NULL;
+
+	for (i = 0; i < ZRAM_WB_MAX_INFLIGHT; i++) {
+		batches[i].zram = zram;
+		init_completion(&batches[i].done);
+		for (j = 0; j < ZRAM_WB_BATCH_PAGES; j++) {
+			batches[i].pages[j] = alloc_page(GFP_KERNEL);
+			if (!batches[i].pages[j]) {
+				zram_wb_batches_free(batches);
+				return NULL;
+			}
+		}
+	}
+
+	return batches;
+}
+
 static ssize_t writeback_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t len)
 {
 	struct zram *zram = dev_to_zram(dev);
 	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
-	unsigned long index;
-	struct bio bio;
-	struct page *page;
+	unsigned long index, hint = 0;
+	struct zram_wb_batch *batches, *batch;
+	unsigned int cur = 0, inflight = 0;
+	ktime_t start;
 	ssize_t ret, sz;
 	char mode_buf[8];
 	int mode = -1;
-	unsigned long blk_idx = 0;
 
 	sz = strscpy(mode_buf, buf, sizeof(mode_buf));
 	if (sz <= 0)
@@ -668,34 +969,18 @@ static ssize_t writeback_store(struct device *dev,
 		goto release_init_lock;
 	}
 
-	page = alloc_page(GFP_KERNEL);
-	if (!page) {
+	batches = zram_wb_batches_alloc(zram);
+	if (!batches) {
 		ret = -ENOMEM;
 		goto release_init_lock;
 	}
 
+	ret = len;
+	start = ktime_get();
+	batch = &batches[0];
 	for (index = 0; index < nr_pages; index++) {
 		struct bio_vec bvec;
-
-		bvec.bv_page = page;
-		bvec.bv_len = PAGE_SIZE;
-		bvec.bv_offset = 0;
-
-		spin_lock(&zram->wb_limit_lock);
-		if (zram->wb_limit_enable && !zram->bd_wb_limit) {
-			spin_unlock(&zram->wb_limit_lock);
-			ret = -EIO;
-			break;
-		}
-		spin_unlock(&zram->wb_limit_lock);
-
-		if (!blk_idx) {
-			blk_idx = alloc_block_bdev(zram);
-			if (!blk_idx) {
-				ret = -ENOSPC;
-				break;
-			}
-		}
+		unsigned int reserved;
 
 		zram_slot_lock(zram, index);
 		if (!zram_allocated(zram, index))
@@ -712,6 +997,12 @@ static ssize_t writeback_store(struct device *dev,
 		if (mode == HUGE_WRITEBACK &&
 			  !zram_test_flag(zram, index, ZRAM_HUGE))
 			goto next;
+
+		if (!zram_wb_limit_reserve(zram, &reserved)) {
+			zram_slot_unlock(zram, index);
+			ret = -EIO;
+			break;
+		}
 		/*
 		 * Clearing ZRAM_UNDER_WB is duty of caller.
 		 * IOW, zram_free_page never clear it.
@@ -720,73 +1011,54 @@ static ssize_t writeback_store(struct device *dev,
 		/* Need for hugepage writeback racing */
 		zram_set_flag(zram, index, ZRAM_IDLE);
 		zram_slot_unlock(zram, index);
+
+		bvec.bv_page = batch->pages[batch->nr_pages];
+		bvec.bv_len = PAGE_SIZE;
+		bvec.bv_offset = 0;
 		if (zram_bvec_read(zram, &bvec, index, 0, NULL)) {
-			zram_slot_lock(zram, index);
-			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
-			zram_clear_flag(zram, index, ZRAM_IDLE);
-			zram_slot_unlock(zram, index);
+			zram_wb_page_abort(zram, index, reserved);
 			continue;
 		}
 
-		bio_init(&bio);
-
-		bio.bi_max_vecs = 1;
-		bio.bi_io_vec = &bvec;
-		bio.bi_bdev = zram->bdev;
-
-		bio.bi_iter.bi_sector = blk_idx * (PAGE_SIZE >> 9);
-		bio_set_op_attrs(&bio, REQ_OP_WRITE, REQ_SYNC);
-		bio_add_page(&bio, bvec.bv_page, bvec.bv_len,
-				bvec.bv_offset);
-		/*
-		 * XXX: A single page IO would be inefficient for write
-		 * but it would be not bad as starter.
-		 */
-		ret = submit_bio_wait(&bio);
-		if (ret) {
-			zram_slot_lock(zram, index);
-			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
-			zram_clear_flag(zram, index, ZRAM_IDLE);
-			zram_slot_unlock(zram, index);
+		batch->reserved[batch->nr_pages] = reserved;
+		batch->index[batch->nr_pages++] = index;
+		if (batch->nr_pages < ZRAM_WB_BATCH_PAGES)
 			continue;
-		}
 
-		atomic64_inc(&zram->stats.bd_writes);
-		/*
-		 * We released zram_slot_lock so need to check if the slot was
-		 * changed. If there is freeing for the slot, we can catch it
-		 * easily by zram_allocated.
-		 * A subtle case is the slot is freed/reallocated/marked as
-		 * ZRAM_IDLE again. To close the race, idle_store doesn't
-		 * mark ZRAM_IDLE once it found the slot was ZRAM_UNDER_WB.
-		 * Thus, we could close the race by checking ZRAM_IDLE bit.
-		 */
-		zram_slot_lock(zram, index);
-		if (!zram_allocated(zram, index) ||
-			  !zram_test_flag(zram, index, ZRAM_IDLE)) {
-			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
-			zram_clear_flag(zram, index, ZRAM_IDLE);
-			goto next;
+		zram_wb_batch_submit(batch, &hint);
+		inflight++;
+		cur = (cur + 1) % ZRAM_WB_MAX_INFLIGHT;
+		batch = &batches[cur];
+		/* Bound the in-flight depth by reusing the oldest batch */
+		if (inflight == ZRAM_WB_MAX_INFLIGHT) {
+			inflight--;
+			if (zram_wb_batch_finish(batch) == -ENOSPC) {
+				ret = -ENOSPC;
+				break;
+			}
 		}
-
-		zram_free_page(zram, index);
-		zram_clear_flag(zram, index, ZRAM_UNDER_WB);
-		zram_set_flag(zram, index, ZRAM_WB);
-		zram_set_element(zram, index, blk_idx);
-		blk_idx = 0;
-		atomic64_inc(&zram->stats.pages_stored);
-		spin_lock(&zram->wb_limit_lock);
-		if (zram->wb_limit_enable && zram->bd_wb_limit > 0)
-			zram->bd_wb_limit -=  1UL << (PAGE_SHIFT - 12);
-		spin_unlock(&zram->wb_limit_lock);
+		continue;
 next:
 		zram_slot_unlock(zram, index);
 	}
 
-	if (blk_idx)
-		free_block_bdev(zram, blk_idx);
-	ret = len;
-	__free_page(page);
+	if (batch->nr_pages) {
+		zram_wb_batch_submit(batch, &hint);
+		inflight++;
+		cur = (cur + 1) % ZRAM_WB_MAX_INFLIGHT;
+	}
+
+	/* Finish the remaining batches, oldest first */
+	for (; inflight; inflight--) {
+		batch = &batches[(cur + ZRAM_WB_MAX_INFLIGHT - inflight) %
+				ZRAM_WB_MAX_INFLIGHT];
+		if (zram_wb_batch_finish(batch) == -ENOSPC)
+			ret = -ENOSPC;
+	}
+
+	atomic64_add(ktime_us_delta(ktime_get(), start),
+			&zram->stats.bd_wb_time_us);
+	zram_wb_batches_free(batches);
 release_init_lock:
 	up_read(&zram->init_lock);
 
@@ -876,10 +1148,34 @@ static void zram_debugfs_destroy(void)
 	debugfs_remove_recursive(zram_debugfs_root);
 }
 
+static u32 zram_get_ac_time(struct zram *zram, u32 index)
+{
+#ifdef ZRAM_AC_TIME_SHIFT
+	return zram->table[index].flags >> ZRAM_AC_TIME_SHIFT;
+#else
+	return zram->table[index].ac_time;
+#endif
+}
+
+static void zram_set_ac_time(struct zram *zram, u32 index, u32 ac_time)
+{
+#ifdef ZRAM_AC_TIME_SHIFT
+	unsigned long flags = zram->table[index].flags;
+
+	BUILD_BUG_ON(__NR_ZRAM_PAGEFLAGS > ZRAM_AC_TIME_SHIFT);
+	flags &= BIT(ZRAM_AC_TIME_SHIFT) - 1;
+	zram->table[index].flags = flags |
+		((unsigned long)ac_time << ZRAM_AC_TIME_SHIFT);
+#else
+	zram->table[index].ac_time = ac_time;
+#endif
+}
+
 static void zram_accessed(struct zram *zram, u32 index)
 {
 	zram_clear_flag(zram, index, ZRAM_IDLE);
-	zram->table[index].ac_time = ktime_get_boottime();
+	zram_set_ac_time(zram, index,
+		(u32)ktime_divns(ktime_get_boottime(), NSEC_PER_SEC));
 }
 
 static ssize_t read_block_state(struct file *file, char __user *buf,
@@ -889,7 +1185,6 @@ static ssize_t read_block_state(struct file *file, char __user *buf,
 	ssize_t index, written = 0;
 	struct zram *zram = file->private_data;
 	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
-	struct timespec64 ts;
 
 	gfp_t kmalloc_flags;
 
@@ -917,11 +1212,10 @@ static ssize_t read_block_state(struct file *file, char __user *buf,
 		if (!zram_allocated(zram, index))
 			goto next;
 
-		ts = ktime_to_timespec64(zram->table[index].ac_time);
+		/* access time is only tracked with second granularity */
 		copied = snprintf(kbuf + written, count,
 			"%12zd %12lld.%06lu %c%c%c%c\n",
-			index, (s64)ts.tv_sec,
-			ts.tv_nsec / NSEC_PER_USEC,
+			index, (s64)zram_get_ac_time(zram, index), 0UL,
 			zram_test_flag(zram, index, ZRAM_SAME) ? 's' : '.',
 			zram_test_flag(zram, index, ZRAM_WB) ? 'w' : '.',
 			zram_test_flag(zram, index, ZRAM_HUGE) ? 'h' : '.',
@@ -999,6 +1293,80 @@ static ssize_t max_comp_streams_store(struct device *dev,
 	return len;
 }
 
+static ssize_t async_write_workers_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	u32 val;
+	struct zram *zram = dev_to_zram(dev);
+
+	down_read(&zram->init_lock);
+	val = zram->async_write_workers;
+	up_read(&zram->init_lock);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", val);
+}
+
+static ssize_t async_write_workers_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned int val;
+	int err;
+
+	err = kstrtouint(buf, 10, &val);
+	if (err)
+		return err;
+
+	if (val > num_possible_cpus())
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change write workers for initialized device\n");
+		return -EBUSY;
+	}
+
+	zram->async_write_workers = val;
+	up_write(&zram->init_lock);
+	return len;
+}
+
+#ifdef CONFIG_ZRAM_DEDUP
+static ssize_t use_dedup_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	bool val;
+	struct zram *zram = dev_to_zram(dev);
+
+	down_read(&zram->init_lock);
+	val = zram->use_dedup;
+	up_read(&zram->init_lock);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", (int)val);
+}
+
+static ssize_t use_dedup_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	int val;
+	struct zram *zram = dev_to_zram(dev);
+
+	if (kstrtoint(buf, 10, &val) || (val != 0 && val != 1))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change dedup usage for initialized device\n");
+		return -EBUSY;
+	}
+	zram->use_dedup = val;
+	up_write(&zram->init_lock);
+	return len;
+}
+#endif
+
 static ssize_t comp_algorithm_show(struct device *dev,
 		struct device_attribute *attr, char *buf)
 {
@@ -1057,6 +1425,201 @@ static ssize_t compact_store(struct device *dev,
 	return len;
 }
 
+#ifdef CONFIG_ZRAM_RECOMPRESS
+static ssize_t recomp_algorithm_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	size_t sz;
+	struct zram *zram = dev_to_zram(dev);
+
+	down_read(&zram->init_lock);
+	sz = zcomp_available_show(zram->recomp_algorithm, buf);
+	up_read(&zram->init_lock);
+
+	return sz;
+}
+
+static ssize_t recomp_algorithm_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	char compressor[ARRAY_SIZE(zram->recomp_algorithm)];
+	size_t sz;
+
+	strlcpy(compressor, buf, sizeof(compressor));
+	/* ignore trailing newline */
+	sz = strlen(compressor);
+	if (sz > 0 && compressor[sz - 1] == '\n')
+		compressor[sz - 1] = 0x00;
+
+	if (!zcomp_available_algorithm(compressor))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change algorithm for initialized device\n");
+		return -EBUSY;
+	}
+
+	strcpy(zram->recomp_algorithm, compressor);
+	up_write(&zram->init_lock);
+	return len;
+}
+
+/*
+ * Recompress the slot with the secondary algorithm and keep the result
+ * only if it is smaller than what is stored now. Called with the slot
+ * lock held, so neither compression nor allocation may sleep here.
+ */
+static int zram_recompress(struct zram *zram, u32 index, struct page *page)
+{
+	unsigned long handle;
+	unsigned int comp_len, old_len;
+	struct zcomp_strm *zstrm;
+	void *src, *dst;
+	bool idle;
+	int ret;
+
+	old_len = zram_get_obj_size(zram, index);
+	ret = zram_read_from_zspool(zram, page, index);
+	if (ret)
+		return ret;
+
+	zstrm = zcomp_stream_get(zram->recomp);
+	src = kmap_atomic(page);
+	ret = zcomp_compress(zstrm, src, &comp_len);
+	kunmap_atomic(src);
+
+	if (ret || comp_len >= huge_class_size || comp_len >= old_len) {
+		zcomp_stream_put(zram->recomp);
+		return ret;
+	}
+
+	handle = zs_malloc(zram->mem_pool, comp_len,
+			__GFP_KSWAPD_RECLAIM |
+			__GFP_NOWARN |
+			__GFP_HIGHMEM |
+			__GFP_MOVABLE |
+			__GFP_CMA);
+	if (!handle) {
+		zcomp_stream_put(zram->recomp);
+		return -ENOMEM;
+	}
+
+	dst = zs_map_object(zram->mem_pool, handle, ZS_MM_WO);
+	memcpy(dst, zstrm->buffer, comp_len);
+	zcomp_stream_put(zram->recomp);
+	zs_unmap_object(zram->mem_pool, handle);
+
+	idle = zram_test_flag(zram, index, ZRAM_IDLE);
+	zram_free_page(zram, index);
+	zram_set_handle(zram, index, handle);
+	zram_set_obj_size(zram, index, comp_len);
+	zram_set_flag(zram, index, ZRAM_RECOMP);
+	zram->table[index].recomp_saved = old_len - comp_len;
+	if (idle)
+		zram_set_flag(zram, index, ZRAM_IDLE);
+
+	atomic64_add(comp_len, &zram->stats.compr_data_size);
+	atomic64_add(old_len - comp_len, &zram->stats.recomp_saved);
+	atomic64_inc(&zram->stats.pages_stored);
+	return 0;
+}
+
+#define HUGE_RECOMP		1
+#define IDLE_RECOMP		2
+#define HUGE_IDLE_RECOMP	(HUGE_RECOMP | IDLE_RECOMP)
+
+static ssize_t recompress_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
+	unsigned long index;
+	struct page *page;
+	char mode_buf[10];
+	int mode = -1;
+	ssize_t ret, sz;
+
+	sz = strscpy(mode_buf, buf, sizeof(mode_buf));
+	if (sz <= 0)
+		return -EINVAL;
+
+	/* ignore trailing newline */
+	if (mode_buf[sz - 1] == '\n')
+		mode_buf[sz - 1] = 0x00;
+
+	if (!strcmp(mode_buf, "idle"))
+		mode = IDLE_RECOMP;
+	else if (!strcmp(mode_buf, "huge"))
+		mode = HUGE_RECOMP;
+	else if (!strcmp(mode_buf, "huge_idle"))
+		mode = HUGE_IDLE_RECOMP;
+
+	if (mode == -1)
+		return -EINVAL;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		ret = -EINVAL;
+		goto release_init_lock;
+	}
+
+	if (!zram->recomp) {
+		ret = -ENODEV;
+		goto release_init_lock;
+	}
+
+	page = alloc_page(GFP_KERNEL);
+	if (!page) {
+		ret = -ENOMEM;
+		goto release_init_lock;
+	}
+
+	for (index = 0; index < nr_pages; index++) {
+		zram_slot_lock(zram, index);
+		if (!zram_allocated(zram, index))
+			goto next;
+
+		if (zram_test_flag(zram, index, ZRAM_WB) ||
+				zram_test_flag(zram, index, ZRAM_SAME) ||
+				zram_test_flag(zram, index, ZRAM_UNDER_WB) ||
+				zram_test_flag(zram, index, ZRAM_RECOMP))
+			goto next;
+
+		/* Recompressing one user of a shared object saves nothing */
+		if (zram_test_flag(zram, index, ZRAM_DEDUP) &&
+			  zram_dedup_shared(zram, zram_get_entry(zram, index)))
+			goto next;
+
+		if ((mode & IDLE_RECOMP) &&
+			  !zram_test_flag(zram, index, ZRAM_IDLE))
+			goto next;
+		if ((mode & HUGE_RECOMP) &&
+			  !zram_test_flag(zram, index, ZRAM_HUGE))
+			goto next;
+
+		/*
+		 * Failures, usually zs_malloc() running out of memory in
+		 * this atomic context, only cost the saving for this slot.
+		 */
+		if (zram_recompress(zram, index, page))
+			atomic64_inc(&zram->stats.recomp_failed);
+next:
+		zram_slot_unlock(zram, index);
+		cond_resched();
+	}
+
+	ret = len;
+	__free_page(page);
+release_init_lock:
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+#endif
+
 static ssize_t io_stat_show(struct device *dev,
 		struct device_attribute *attr, char *buf)
 {
@@ -1065,11 +1628,12 @@ static ssize_t io_stat_show(struct device *dev,
 
 	down_read(&zram->init_lock);
 	ret = scnprintf(buf, PAGE_SIZE,
-			"%8llu %8llu %8llu %8llu\n",
+			"%8llu %8llu %8llu %8llu %8llu\n",
 			(u64)atomic64_read(&zram->stats.failed_reads),
 			(u64)atomic64_read(&zram->stats.failed_writes),
 			(u64)atomic64_read(&zram->stats.invalid_io),
-			(u64)atomic64_read(&zram->stats.notify_free));
+			(u64)atomic64_read(&zram->stats.notify_free),
+			(u64)atomic64_read(&zram->stats.recomp_failed));
 	up_read(&zram->init_lock);
 
 	return ret;
@@ -1096,7 +1660,7 @@ static ssize_t mm_stat_show(struct device *dev,
 	max_used = atomic_long_read(&zram->stats.max_used_pages);
 
 	ret = scnprintf(buf, PAGE_SIZE,
-			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu\n",
+			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu %8llu %8llu %8llu\n",
 			orig_size << PAGE_SHIFT,
 			(u64)atomic64_read(&zram->stats.compr_data_size),
 			mem_used << PAGE_SHIFT,
@@ -1104,7 +1668,10 @@ static ssize_t mm_stat_show(struct device *dev,
 			max_used << PAGE_SHIFT,
 			(u64)atomic64_read(&zram->stats.same_pages),
 			pool_stats.pages_compacted,
-			(u64)atomic64_read(&zram->stats.huge_pages));
+			(u64)atomic64_read(&zram->stats.huge_pages),
+			(u64)atomic64_read(&zram->stats.recomp_saved),
+			(u64)atomic64_read(&zram->stats.dup_data_size),
+			(u64)atomic64_read(&zram->stats.meta_data_size));
 	up_read(&zram->init_lock);
 
 	return ret;
@@ -1120,10 +1687,13 @@ static ssize_t bd_stat_show(struct device *dev,
 
 	down_read(&zram->init_lock);
 	ret = scnprintf(buf, PAGE_SIZE,
-		"%8llu %8llu %8llu\n",
+		"%8llu %8llu %8llu %8llu %8llu %8llu\n",
 			FOUR_K((u64)atomic64_read(&zram->stats.bd_count)),
 			FOUR_K((u64)atomic64_read(&zram->stats.bd_reads)),
-			FOUR_K((u64)atomic64_read(&zram->stats.bd_writes)));
+			FOUR_K((u64)atomic64_read(&zram->stats.bd_writes)),
+			(u64)atomic64_read(&zram->stats.bd_wb_bios),
+			(u64)atomic64_read(&zram->stats.bd_wb_time_us),
+			(u64)atomic64_read(&zram->stats.bd_read_time_us));
 	up_read(&zram->init_lock);
 
 	return ret;
@@ -1164,6 +1734,7 @@ static void zram_meta_free(struct zram *zram, u64 disksize)
 	for (index = 0; index < num_pages; index++)
 		zram_free_page(zram, index);
 
+	zram_dedup_fini(zram);
 	zs_destroy_pool(zram->mem_pool);
 	vfree(zram->table);
 }
@@ -1183,6 +1754,12 @@ static bool zram_meta_alloc(struct zram *zram, u64 disksize)
 		return false;
 	}
 
+	if (zram_dedup_init(zram, num_pages)) {
+		zs_destroy_pool(zram->mem_pool);
+		vfree(zram->table);
+		return false;
+	}
+
 	if (!huge_class_size)
 		huge_class_size = zs_huge_class_size(zram->mem_pool);
 	return true;
@@ -1198,7 +1775,7 @@ static void zram_free_page(struct zram *zram, size_t index)
 	unsigned long handle;
 
 #ifdef CONFIG_ZRAM_MEMORY_TRACKING
-	zram->table[index].ac_time.tv64 = 0;
+	zram_set_ac_time(zram, index, 0);
 #endif
 	if (zram_test_flag(zram, index, ZRAM_IDLE))
 		zram_clear_flag(zram, index, ZRAM_IDLE);
@@ -1208,6 +1785,15 @@ static void zram_free_page(struct zram *zram, size_t index)
 		atomic64_dec(&zram->stats.huge_pages);
 	}
 
+#ifdef CONFIG_ZRAM_RECOMPRESS
+	if (zram_test_flag(zram, index, ZRAM_RECOMP)) {
+		zram_clear_flag(zram, index, ZRAM_RECOMP);
+		atomic64_sub(zram->table[index].recomp_saved,
+				&zram->stats.recomp_saved);
+		zram->table[index].recomp_saved = 0;
+	}
+#endif
+
 	if (zram_test_flag(zram, index, ZRAM_WB)) {
 		zram_clear_flag(zram, index, ZRAM_WB);
 		free_block_bdev(zram, zram_get_element(zram, index));
@@ -1224,6 +1810,12 @@ static void zram_free_page(struct zram *zram, size_t index)
 		goto out;
 	}
 
+	if (zram_test_flag(zram, index, ZRAM_DEDUP)) {
+		zram_dedup_put(zram, zram_get_entry(zram, index));
+		zram_clear_flag(zram, index, ZRAM_DEDUP);
+		goto out;
+	}
+
 	handle = zram_get_handle(zram, index);
 	if (!handle)
 		return;
@@ -1240,28 +1832,18 @@ static void zram_free_page(struct zram *zram, size_t index)
 		~(1UL << ZRAM_LOCK | 1UL << ZRAM_UNDER_WB));
 }
 
-static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
-				struct bio *bio, bool partial_io)
+/*
+ * Decompress the slot's zsmalloc object (or fill the same element page)
+ * into @page. Caller should hold the slot lock.
+ */
+static int zram_read_from_zspool(struct zram *zram, struct page *page,
+				u32 index)
 {
 	int ret;
 	unsigned long handle;
 	unsigned int size;
 	void *src, *dst;
 
-	zram_slot_lock(zram, index);
-	if (zram_test_flag(zram, index, ZRAM_WB)) {
-		struct bio_vec bvec;
-
-		zram_slot_unlock(zram, index);
-
-		bvec.bv_page = page;
-		bvec.bv_len = PAGE_SIZE;
-		bvec.bv_offset = 0;
-		return read_from_bdev(zram, &bvec,
-				zram_get_element(zram, index),
-				bio, partial_io);
-	}
-
 	handle = zram_get_handle(zram, index);
 	if (!handle || zram_test_flag(zram, index, ZRAM_SAME)) {
 		unsigned long value;
@@ -1271,7 +1853,6 @@ static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
 		mem = kmap_atomic(page);
 		zram_fill_page(mem, PAGE_SIZE, value);
 		kunmap_atomic(mem);
-		zram_slot_unlock(zram, index);
 		return 0;
 	}
 
@@ -1284,14 +1865,39 @@ static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
 		kunmap_atomic(dst);
 		ret = 0;
 	} else {
-		struct zcomp_strm *zstrm = zcomp_stream_get(zram->comp);
+		struct zcomp *comp = zram_slot_comp(zram, index);
+		struct zcomp_strm *zstrm = zcomp_stream_get(comp);
 
 		dst = kmap_atomic(page);
 		ret = zcomp_decompress(zstrm, src, size, dst);
 		kunmap_atomic(dst);
-		zcomp_stream_put(zram->comp);
+		zcomp_stream_put(comp);
 	}
 	zs_unmap_object(zram->mem_pool, handle);
+
+	return ret;
+}
+
+static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
+				struct bio *bio, bool partial_io)
+{
+	int ret;
+
+	zram_slot_lock(zram, index);
+	if (zram_test_flag(zram, index, ZRAM_WB)) {
+		struct bio_vec bvec;
+
+		zram_slot_unlock(zram, index);
+
+		bvec.bv_page = page;
+		bvec.bv_len = PAGE_SIZE;
+		bvec.bv_offset = 0;
+		return read_from_bdev(zram, &bvec,
+				zram_get_element(zram, index),
+				bio, partial_io);
+	}
+
+	ret = zram_read_from_zspool(zram, page, index);
 	zram_slot_unlock(zram, index);
 
 	/* Should NEVER happen. Return bio error if it does. */
@@ -1346,6 +1952,8 @@ static int __zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
 	struct page *page = bvec->bv_page;
 	unsigned long element = 0;
 	enum zram_pageflags flags = 0;
+	struct zram_entry *entry = NULL;
+	u32 checksum = 0;
 
 	mem = kmap_atomic(page);
 	if (page_same_filled(mem, &element)) {
@@ -1357,6 +1965,12 @@ static int __zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
 	}
 	kunmap_atomic(mem);
 
+	entry = zram_dedup_find(zram, page, &checksum);
+	if (entry) {
+		comp_len = entry->len;
+		goto out;
+	}
+
 compress_again:
 	zstrm = zcomp_stream_get(zram->comp);
 	src = kmap_atomic(page);
@@ -1424,6 +2038,7 @@ static int __zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
 	zcomp_stream_put(zram->comp);
 	zs_unmap_object(zram->mem_pool, handle);
 	atomic64_add(comp_len, &zram->stats.compr_data_size);
+	entry = zram_dedup_new(zram, handle, comp_len, checksum);
 out:
 	/*
 	 * Free memory associated with this sector
@@ -1440,7 +2055,10 @@ static int __zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
 	if (flags) {
 		zram_set_flag(zram, index, flags);
 		zram_set_element(zram, index, element);
-	}  else {
+	} else if (entry) {
+		zram_set_entry(zram, index, entry);
+		zram_set_obj_size(zram, index, comp_len);
+	} else {
 		zram_set_handle(zram, index, handle);
 		zram_set_obj_size(zram, index, comp_len);
 	}
@@ -1570,12 +2188,67 @@ static int zram_bvec_rw(struct zram *zram, struct bio_vec *bvec, u32 index,
 	return ret;
 }
 
+struct zram_write_work {
+	struct work_struct work;
+	struct zram *zram;
+	struct bio *bio;
+	struct bio_vec bvec;
+	u32 index;
+	int offset;
+};
+
+static void zram_async_write(struct work_struct *work)
+{
+	struct zram_write_work *zw = container_of(work,
+					struct zram_write_work, work);
+	struct bio *bio = zw->bio;
+
+	if (zram_bvec_rw(zw->zram, &zw->bvec, zw->index, zw->offset,
+				true, bio) < 0)
+		bio->bi_error = -EIO;
+
+	kfree(zw);
+	/* drops the reference taken in zram_queue_write */
+	bio_endio(bio);
+}
+
+/*
+ * Hand a full page write over to the device's write workers. The parent
+ * bio gets an extra remaining count per queued page and is completed by
+ * whoever drops the last one. Returns false if the caller should do the
+ * write synchronously instead.
+ */
+static bool zram_queue_write(struct zram *zram, struct bio_vec *bvec,
+			u32 index, int offset, struct bio *bio)
+{
+	struct zram_write_work *zw;
+
+	if (!zram->async_wq || is_partial_io(bvec))
+		return false;
+
+	zw = kmalloc(sizeof(*zw), GFP_NOIO | __GFP_NOWARN);
+	if (!zw)
+		return false;
+
+	INIT_WORK(&zw->work, zram_async_write);
+	zw->zram = zram;
+	zw->bio = bio;
+	zw->bvec = *bvec;
+	zw->index = index;
+	zw->offset = offset;
+
+	bio_inc_remaining(bio);
+	queue_work(zram->async_wq, &zw->work);
+	return true;
+}
+
 static void __zram_make_request(struct zram *zram, struct bio *bio)
 {
 	int offset;
 	u32 index;
 	struct bio_vec bvec;
 	struct bvec_iter iter;
+	bool is_write = op_is_write(bio_op(bio));
 
 	index = bio->bi_iter.bi_sector >> SECTORS_PER_PAGE_SHIFT;
 	offset = (bio->bi_iter.bi_sector &
@@ -1594,10 +2267,14 @@ static void __zram_make_request(struct zram *zram, struct bio *bio)
 		do {
 			bv.bv_len = min_t(unsigned int, PAGE_SIZE - offset,
 							unwritten);
+			if (is_write && zram_queue_write(zram, &bv, index,
+							offset, bio))
+				goto next;
+
 			if (zram_bvec_rw(zram, &bv, index, offset,
-					op_is_write(bio_op(bio)), bio) < 0)
+					is_write, bio) < 0)
 				goto out;
-
+next:
 			bv.bv_offset += bv.bv_len;
 			unwritten -= bv.bv_len;
 
@@ -1660,6 +2337,13 @@ static int zram_rw_page(struct block_device *bdev, sector_t sector,
 
 	zram = bdev->bd_disk->private_data;
 
+	/*
+	 * rw_page has to finish the write before returning, so send it
+	 * back to the bio path where the write workers can pick it up.
+	 */
+	if (is_write && zram->async_wq)
+		return -EOPNOTSUPP;
+
 	if (!valid_io_request(zram, sector, PAGE_SIZE)) {
 		atomic64_inc(&zram->stats.invalid_io);
 		ret = -EINVAL;
@@ -1702,6 +2386,7 @@ static int zram_rw_page(struct block_device *bdev, sector_t sector,
 static void zram_reset_device(struct zram *zram)
 {
 	struct zcomp *comp;
+	struct workqueue_struct *async_wq;
 	u64 disksize;
 
 	down_write(&zram->init_lock);
@@ -1716,15 +2401,25 @@ static void zram_reset_device(struct zram *zram)
 	comp = zram->comp;
 	disksize = zram->disksize;
 	zram->disksize = 0;
+	async_wq = zram->async_wq;
+	zram->async_wq = NULL;
 
 	set_capacity(zram->disk, 0);
 	part_stat_set_all(&zram->disk->part0, 0);
 
 	up_write(&zram->init_lock);
+	if (async_wq)
+		destroy_workqueue(async_wq);
 	/* I/O operation under all of CPU are done so let's free */
 	zram_meta_free(zram, disksize);
 	memset(&zram->stats, 0, sizeof(zram->stats));
 	zcomp_destroy(comp);
+#ifdef CONFIG_ZRAM_RECOMPRESS
+	if (zram->recomp) {
+		zcomp_destroy(zram->recomp);
+		zram->recomp = NULL;
+	}
+#endif
 	reset_bdev(zram);
 }
 
@@ -1761,6 +2456,34 @@ static ssize_t disksize_store(struct device *dev,
 		goto out_free_meta;
 	}
 
+#ifdef CONFIG_ZRAM_RECOMPRESS
+	if (zram->recomp_algorithm[0]) {
+		zram->recomp = zcomp_create(zram->recomp_algorithm);
+		if (IS_ERR(zram->recomp)) {
+			pr_err("Cannot initialise %s recompressing backend\n",
+					zram->recomp_algorithm);
+			err = PTR_ERR(zram->recomp);
+			zram->recomp = NULL;
+			goto out_free_comp;
+		}
+	}
+#endif
+
+	if (zram->async_write_workers) {
+		/*
+		 * Writes may come from reclaim, so the workqueue needs a
+		 * rescuer to guarantee forward progress.
+		 */
+		zram->async_wq = alloc_workqueue("%s_write",
+				WQ_UNBOUND | WQ_HIGHPRI | WQ_MEM_RECLAIM,
+				zram->async_write_workers,
+				zram->disk->disk_name);
+		if (!zram->async_wq) {
+			err = -ENOMEM;
+			goto out_free_recomp;
+		}
+	}
+
 	zram->comp = comp;
 	zram->disksize = disksize;
 	set_capacity(zram->disk, zram->disksize >> SECTOR_SHIFT);
@@ -1770,6 +2493,15 @@ static ssize_t disksize_store(struct device *dev,
 
 	return len;
 
+out_free_recomp:
+#ifdef CONFIG_ZRAM_RECOMPRESS
+	if (zram->recomp) {
+		zcomp_destroy(zram->recomp);
+		zram->recomp = NULL;
+	}
+#endif
+out_free_comp:
+	zcomp_destroy(comp);
 out_free_meta:
 	zram_meta_free(zram, disksize);
 out_unlock:
@@ -1852,7 +2584,15 @@ static DEVICE_ATTR_WO(mem_limit);
 static DEVICE_ATTR_WO(mem_used_max);
 static DEVICE_ATTR_WO(idle);
 static DEVICE_ATTR_RW(max_comp_streams);
+static DEVICE_ATTR_RW(async_write_workers);
+#ifdef CONFIG_ZRAM_DEDUP
+static DEVICE_ATTR_RW(use_dedup);
+#endif
 static DEVICE_ATTR_RW(comp_algorithm);
+#ifdef CONFIG_ZRAM_RECOMPRESS
+static DEVICE_ATTR_RW(recomp_algorithm);
+static DEVICE_ATTR_WO(recompress);
+#endif
 #ifdef CONFIG_ZRAM_WRITEBACK
 static DEVICE_ATTR_RW(backing_dev);
 static DEVICE_ATTR_WO(writeback);
@@ -1869,7 +2609,15 @@ static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_mem_used_max.attr,
 	&dev_attr_idle.attr,
 	&dev_attr_max_comp_streams.attr,
+	&dev_attr_async_write_workers.attr,
+#ifdef CONFIG_ZRAM_DEDUP
+	&dev_attr_use_dedup.attr,
+#endif
 	&dev_attr_comp_algorithm.attr,
+#ifdef CONFIG_ZRAM_RECOMPRESS
+	&dev_attr_recomp_algorithm.attr,
+	&dev_attr_recompress.attr,
+#endif
 #ifdef CONFIG_ZRAM_WRITEBACK
 	&dev_attr_backing_dev.attr,
 	&dev_attr_writeback.attr,
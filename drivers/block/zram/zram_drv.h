@@ -16,10 +16,14 @@
 #define _ZRAM_DRV_H_
 
 #include <linux/rwsem.h>
+#include <linux/rbtree.h>
+#include <linux/spinlock.h>
 #include <linux/zsmalloc.h>
 #include <linux/crypto.h>
+#include <linux/workqueue.h>
 
 #include "zcomp.h"
+#include "zram_dedup.h"
 
 #define SECTOR_SHIFT		9
 #define SECTORS_PER_PAGE_SHIFT	(PAGE_SHIFT - SECTOR_SHIFT)
@@ -42,6 +46,16 @@
  */
 #define ZRAM_FLAG_SHIFT 24
 
+/*
+ * With CONFIG_ZRAM_MEMORY_TRACKING the last access time of a slot is a
+ * coarse tick in seconds since boot. On 64bit it lives in the upper half
+ * of table.flags, above zram_pageflags, so that a table entry stays two
+ * words (16 bytes) per page instead of three.
+ */
+#if BITS_PER_LONG == 64
+#define ZRAM_AC_TIME_SHIFT 32
+#endif
+
 /* Flags for zram pages (table[page_no].flags) */
 enum zram_pageflags {
 	/* zram slot is locked */
@@ -51,21 +65,42 @@ enum zram_pageflags {
 	ZRAM_UNDER_WB,	/* page is under writeback */
 	ZRAM_HUGE,	/* Incompressible page */
 	ZRAM_IDLE,	/* not accessed page since last idle marking */
+	ZRAM_RECOMP,	/* page is compressed with the secondary algorithm */
+	ZRAM_DEDUP,	/* slot points to a shared zram_entry */
 
 	__NR_ZRAM_PAGEFLAGS,
 };
 
 /*-- Data structures */
 
+/* Compressed object shared by all slots with identical content */
+struct zram_entry {
+	struct rb_node rb_node;
+	u32 len;
+	u32 checksum;
+	unsigned long refcount;		/* users and in-flight lookups */
+	unsigned long users;		/* slots pointing at the entry */
+	unsigned long handle;
+};
+
+struct zram_hash {
+	spinlock_t lock;
+	struct rb_root rb_root;
+};
+
 /* Allocated for each disk page */
 struct zram_table_entry {
 	union {
 		unsigned long handle;
 		unsigned long element;
+		struct zram_entry *entry;	/* ZRAM_DEDUP slots */
 	};
 	unsigned long flags;
-#ifdef CONFIG_ZRAM_MEMORY_TRACKING
-	ktime_t ac_time;
+#if defined(CONFIG_ZRAM_MEMORY_TRACKING) && !defined(ZRAM_AC_TIME_SHIFT)
+	u32 ac_time;
+#endif
+#ifdef CONFIG_ZRAM_RECOMPRESS
+	u16 recomp_saved;	/* bytes saved by recompressing the slot */
 #endif
 };
 
@@ -83,10 +118,17 @@ struct zram_stats {
 	atomic_long_t max_used_pages;	/* no. of maximum pages stored */
 	atomic64_t writestall;		/* no. of write slow paths */
 	atomic64_t miss_free;		/* no. of missed free */
+	atomic64_t recomp_saved;	/* bytes currently saved by recomp */
+	atomic64_t recomp_failed;	/* no. of slots recomp had to skip */
+	atomic64_t dup_data_size;	/* compressed bytes shared by dedup */
+	atomic64_t meta_data_size;	/* dedup metadata overhead */
 #ifdef	CONFIG_ZRAM_WRITEBACK
 	atomic64_t bd_count;		/* no. of pages in backing device */
 	atomic64_t bd_reads;		/* no. of reads from backing device */
 	atomic64_t bd_writes;		/* no. of writes from backing device */
+	atomic64_t bd_wb_bios;		/* no. of bios issued by writeback */
+	atomic64_t bd_wb_time_us;	/* time spent in writeback */
+	atomic64_t bd_read_time_us;	/* time spent reading from bdev */
 #endif
 };
 
@@ -109,6 +151,22 @@ struct zram {
 	 */
 	u64 disksize;	/* bytes */
 	char compressor[CRYPTO_MAX_ALG_NAME];
+#ifdef CONFIG_ZRAM_RECOMPRESS
+	/* secondary compressor used to recompress idle/huge pages */
+	struct zcomp *recomp;
+	char recomp_algorithm[CRYPTO_MAX_ALG_NAME];
+#endif
+	/*
+	 * number of workers compressing writes asynchronously,
+	 * 0 means writes are compressed in the submitter's context
+	 */
+	unsigned int async_write_workers;
+	struct workqueue_struct *async_wq;
+#ifdef CONFIG_ZRAM_DEDUP
+	bool use_dedup;
+	struct zram_hash *hash;
+	size_t hash_size;
+#endif
 	/*
 	 * zram is claimed so open request will be failed
 	 */
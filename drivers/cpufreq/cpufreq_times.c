@@ -16,14 +16,20 @@
 #include <linux/cpufreq.h>
 #include <linux/cpufreq_times.h>
 #include <linux/cputime.h>
+#include <linux/hash.h>
 #include <linux/hashtable.h>
 #include <linux/init.h>
+#include <linux/kthread.h>
+#include <linux/mutex.h>
 #include <linux/proc_fs.h>
 #include <linux/sched.h>
 #include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/threads.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <uapi/linux/uid_stats.h>
 
 #define UID_HASH_BITS 10
 
@@ -45,6 +51,8 @@ struct uid_entry {
 	struct hlist_node hash;
 	struct rcu_head rcu;
 	struct concurrent_times *concurrent_times;
+	/* uid_stats_gen of the first binary snapshot to see the last change */
+	u64 gen;
 	u64 time_in_state[0];
 };
 
@@ -53,12 +61,16 @@ struct uid_entry {
  * @offset: start of these freqs' stats in task time_in_state array
  * @max_state: number of entries in freq_table
  * @last_index: index in freq_table of last frequency switched to
+ * @first_cpu: first cpu of the policy these freqs belong to
+ * @related_cpus: cpus of the policy these freqs belong to
  * @freq_table: list of available frequencies
  */
 struct cpu_freqs {
 	unsigned int offset;
 	unsigned int max_state;
 	unsigned int last_index;
+	unsigned int first_cpu;
+	struct cpumask related_cpus;
 	unsigned int freq_table[0];
 };
 
@@ -66,6 +78,45 @@ static struct cpu_freqs *all_freqs[NR_CPUS];
 
 static unsigned int next_offset;
 
+/* Generation of the last binary snapshot, protected by uid_lock */
+static u64 uid_stats_gen;
+
+/*
+ * UID times are first accumulated in a small per-cpu buffer, so that the
+ * tick neither takes uid_lock nor writes to a uid_entry shared with other
+ * cpus. A buffer slot is folded into uid_hash_table when another UID
+ * hashing to the same slot shows up on that cpu, and all slots are folded
+ * before any of the uid files are read.
+ */
+#define UID_BUF_BITS 3
+#define UID_BUF_SLOTS (1 << UID_BUF_BITS)
+
+/**
+ * struct uid_buf_slot - not yet folded time of one UID on one cpu
+ * @uid: UID the times belong to
+ * @used: slot holds times for @uid
+ * @max_state: number of entries in @time_in_state
+ * @time_in_state: time per frequency state, indexed like uid_entry's
+ * @active: time per number of concurrently active cpus
+ * @policy: time per number of concurrently active cpus of each policy
+ */
+struct uid_buf_slot {
+	uid_t uid;
+	bool used;
+	unsigned int max_state;
+	u64 *time_in_state;
+	u64 active[NR_CPUS];
+	u64 policy[NR_CPUS];
+};
+
+/* Only ever contended by readers folding the buffer */
+struct uid_buf {
+	spinlock_t lock;
+	struct uid_buf_slot slot[UID_BUF_SLOTS];
+};
+
+static DEFINE_PER_CPU(struct uid_buf, uid_bufs);
+
 
 /* Caller must hold rcu_read_lock() */
 static struct uid_entry *find_uid_entry_rcu(uid_t uid)
@@ -139,6 +190,64 @@ static struct uid_entry *find_or_register_uid_locked(uid_t uid)
 	return uid_entry;
 }
 
+/* Caller must hold the lock of the buffer @slot belongs to */
+static void uid_buf_clear_slot(struct uid_buf_slot *slot)
+{
+	memset(slot->time_in_state, 0,
+	       slot->max_state * sizeof(slot->time_in_state[0]));
+	memset(slot->active, 0, sizeof(slot->active));
+	memset(slot->policy, 0, sizeof(slot->policy));
+	slot->used = false;
+}
+
+/* Caller must hold uid lock and the lock of the buffer @slot belongs to */
+static void uid_buf_fold_slot_locked(struct uid_buf_slot *slot)
+{
+	struct uid_entry *uid_entry;
+	unsigned int i, max_state;
+
+	if (!slot->used)
+		return;
+
+	uid_entry = find_or_register_uid_locked(slot->uid);
+	if (uid_entry) {
+		max_state = min(slot->max_state, uid_entry->max_state);
+		for (i = 0; i < max_state; i++)
+			uid_entry->time_in_state[i] += slot->time_in_state[i];
+		uid_entry->gen = uid_stats_gen + 1;
+
+		for (i = 0; i < NR_CPUS; i++) {
+			if (slot->active[i])
+				atomic64_add(slot->active[i],
+				     &uid_entry->concurrent_times->active[i]);
+			if (slot->policy[i])
+				atomic64_add(slot->policy[i],
+				     &uid_entry->concurrent_times->policy[i]);
+		}
+	}
+
+	uid_buf_clear_slot(slot);
+}
+
+/* Fold every cpu's buffered UID times into uid_hash_table */
+static void uid_bufs_fold(void)
+{
+	struct uid_buf *buf;
+	unsigned long flags;
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		buf = &per_cpu(uid_bufs, cpu);
+
+		spin_lock_irqsave(&buf->lock, flags);
+		spin_lock(&uid_lock);
+		for (i = 0; i < UID_BUF_SLOTS; i++)
+			uid_buf_fold_slot_locked(&buf->slot[i]);
+		spin_unlock(&uid_lock);
+		spin_unlock_irqrestore(&buf->lock, flags);
+	}
+}
+
 static int single_uid_time_in_state_show(struct seq_file *m, void *ptr)
 {
 	struct uid_entry *uid_entry;
@@ -148,6 +257,8 @@ static int single_uid_time_in_state_show(struct seq_file *m, void *ptr)
 	if (uid == overflowuid)
 		return -EINVAL;
 
+	uid_bufs_fold();
+
 	rcu_read_lock();
 
 	uid_entry = find_uid_entry_rcu(uid);
@@ -171,6 +282,9 @@ static void *uid_seq_start(struct seq_file *seq, loff_t *pos)
 	if (*pos >= HASH_SIZE(uid_hash_table))
 		return NULL;
 
+	if (!*pos)
+		uid_bufs_fold();
+
 	return &uid_hash_table[*pos];
 }
 
@@ -397,16 +511,76 @@ int proc_time_in_state_show(struct seq_file *m, struct pid_namespace *ns,
 	return 0;
 }
 
+/*
+ * Return @uid's slot in this cpu's buffer, folding out whichever UID held
+ * it before. Caller must hold buf->lock.
+ */
+static struct uid_buf_slot *uid_buf_get_slot(struct uid_buf *buf, uid_t uid)
+{
+	struct uid_buf_slot *slot = &buf->slot[hash_32(uid, UID_BUF_BITS)];
+	unsigned int max_state = READ_ONCE(next_offset);
+
+	if (slot->used && slot->uid != uid) {
+		spin_lock(&uid_lock);
+		uid_buf_fold_slot_locked(slot);
+		spin_unlock(&uid_lock);
+	}
+
+	if (slot->max_state < max_state) {
+		u64 *temp;
+
+		temp = krealloc(slot->time_in_state,
+				max_state * sizeof(slot->time_in_state[0]),
+				GFP_ATOMIC);
+		if (!temp)
+			return NULL;
+		memset(temp + slot->max_state, 0,
+		       (max_state - slot->max_state) * sizeof(temp[0]));
+		slot->time_in_state = temp;
+		slot->max_state = max_state;
+	}
+
+	slot->uid = uid;
+	slot->used = true;
+
+	return slot;
+}
+
+/*
+ * Buffer @cputime for @uid on this cpu, at frequency state @state and at
+ * the concurrent active and policy indices. A negative index is skipped.
+ */
+static void uid_buf_add(uid_t uid, unsigned int state, int active,
+			int policy, cputime_t cputime)
+{
+	struct uid_buf_slot *slot;
+	struct uid_buf *buf;
+	unsigned long flags;
+
+	buf = get_cpu_ptr(&uid_bufs);
+	spin_lock_irqsave(&buf->lock, flags);
+
+	slot = uid_buf_get_slot(buf, uid);
+	if (slot) {
+		if (state < slot->max_state)
+			slot->time_in_state[state] += cputime;
+		if (active >= 0)
+			slot->active[active] += cputime;
+		if (policy >= 0)
+			slot->policy[policy] += cputime;
+	}
+
+	spin_unlock_irqrestore(&buf->lock, flags);
+	put_cpu_ptr(&uid_bufs);
+}
+
 void cpufreq_acct_update_power(struct task_struct *p, cputime_t cputime)
 {
 	unsigned long flags;
 	unsigned int state;
 	unsigned int active_cpu_cnt = 0;
 	unsigned int policy_cpu_cnt = 0;
-	unsigned int policy_first_cpu;
-	struct uid_entry *uid_entry;
 	struct cpu_freqs *freqs = all_freqs[task_cpu(p)];
-	struct cpufreq_policy *policy;
 	uid_t uid = from_kuid_munged(current_user_ns(), task_uid(p));
 	int cpu = 0;
 
@@ -415,53 +589,34 @@ void cpufreq_acct_update_power(struct task_struct *p, cputime_t cputime)
 
 	state = freqs->offset + READ_ONCE(freqs->last_index);
 
-	spin_lock_irqsave(&task_time_in_state_lock, flags);
-	if ((state < p->max_state || !cpufreq_task_times_realloc_locked(p)) &&
-	    p->time_in_state)
+	/*
+	 * Only accounting of @p itself ever grows p->time_in_state, and the
+	 * array is freed once @p is dead, so task_time_in_state_lock is only
+	 * needed to keep readers away from a realloc.
+	 */
+	if (state < p->max_state && p->time_in_state) {
 		p->time_in_state[state] += cputime;
-	spin_unlock_irqrestore(&task_time_in_state_lock, flags);
-
-	spin_lock_irqsave(&uid_lock, flags);
-	uid_entry = find_or_register_uid_locked(uid);
-	if (uid_entry && state < uid_entry->max_state)
-		uid_entry->time_in_state[state] += cputime;
-	spin_unlock_irqrestore(&uid_lock, flags);
-
-	rcu_read_lock();
-	uid_entry = find_uid_entry_rcu(uid);
-	if (!uid_entry) {
-		rcu_read_unlock();
-		return;
+	} else {
+		spin_lock_irqsave(&task_time_in_state_lock, flags);
+		if ((state < p->max_state ||
+		     !cpufreq_task_times_realloc_locked(p)) &&
+		    p->time_in_state)
+			p->time_in_state[state] += cputime;
+		spin_unlock_irqrestore(&task_time_in_state_lock, flags);
 	}
 
 	for_each_possible_cpu(cpu)
 		if (!idle_cpu(cpu))
 			++active_cpu_cnt;
 
-	atomic64_add(cputime,
-		     &uid_entry->concurrent_times->active[active_cpu_cnt - 1]);
-
-	policy = cpufreq_cpu_get(task_cpu(p));
-	if (!policy) {
-		/*
-		 * This CPU may have just come up and not have a cpufreq policy
-		 * yet.
-		 */
-		rcu_read_unlock();
-		return;
-	}
-
-	for_each_cpu(cpu, policy->related_cpus)
+	for_each_cpu(cpu, &freqs->related_cpus)
 		if (!idle_cpu(cpu))
 			++policy_cpu_cnt;
 
-	policy_first_cpu = cpumask_first(policy->related_cpus);
-	cpufreq_cpu_put(policy);
-
-	atomic64_add(cputime,
-		     &uid_entry->concurrent_times->policy[policy_first_cpu +
-							  policy_cpu_cnt - 1]);
-	rcu_read_unlock();
+	uid_buf_add(uid, state, (int)active_cpu_cnt - 1,
+		    policy_cpu_cnt ?
+		    (int)(freqs->first_cpu + policy_cpu_cnt - 1) : -1,
+		    cputime);
 }
 
 static int cpufreq_times_get_index(struct cpu_freqs *freqs, unsigned int freq)
@@ -507,6 +662,9 @@ void cpufreq_times_create_policy(struct cpufreq_policy *policy)
 	if (index >= 0)
 		WRITE_ONCE(freqs->last_index, index);
 
+	freqs->first_cpu = cpumask_first(policy->related_cpus);
+	cpumask_copy(&freqs->related_cpus, policy->related_cpus);
+
 	freqs->offset = next_offset;
 	WRITE_ONCE(next_offset, freqs->offset + count);
 	for_each_cpu(cpu, policy->related_cpus)
@@ -525,7 +683,24 @@ void cpufreq_task_times_remove_uids(uid_t uid_start, uid_t uid_end)
 {
 	struct uid_entry *uid_entry;
 	struct hlist_node *tmp;
+	struct uid_buf *buf;
 	unsigned long flags;
+	int cpu, i;
+
+	/* Drop buffered times so they don't bring the UIDs back */
+	for_each_possible_cpu(cpu) {
+		buf = &per_cpu(uid_bufs, cpu);
+
+		spin_lock_irqsave(&buf->lock, flags);
+		for (i = 0; i < UID_BUF_SLOTS; i++) {
+			struct uid_buf_slot *slot = &buf->slot[i];
+
+			if (slot->used && slot->uid >= uid_start &&
+			    slot->uid <= uid_end)
+				uid_buf_clear_slot(slot);
+		}
+		spin_unlock_irqrestore(&buf->lock, flags);
+	}
 
 	spin_lock_irqsave(&uid_lock, flags);
 
@@ -555,6 +730,156 @@ void cpufreq_times_record_transition(struct cpufreq_policy *policy,
 		WRITE_ONCE(freqs->last_index, index);
 }
 
+struct uid_stats_bin {
+	struct mutex lock;
+	u64 last_gen;
+	void *buf;
+	size_t len;
+};
+
+/*
+ * Take a binary snapshot of uid_time_in_state, see
+ * include/uapi/linux/uid_stats.h. Only UIDs folded into since this file's
+ * previous snapshot are included, unless this is its first one.
+ *
+ * uid_lock is only taken to start a new generation. The entries are read
+ * under RCU like /proc/uid_time_in_state does, and converted to clock
+ * ticks once the walk is done. A UID folded into during the walk has a
+ * generation above the new one and is reported again next time.
+ */
+static int uid_time_in_state_bin_snapshot(struct uid_stats_bin *bin)
+{
+	struct uid_time_in_state_record *rec;
+	struct uid_stats_header *hdr;
+	struct uid_entry *uid_entry;
+	unsigned int nr_states = READ_ONCE(next_offset);
+	unsigned int bkt, i, max_state;
+	size_t rec_size, nr, alloc_nr;
+	unsigned long flags;
+	u64 gen;
+
+	rec_size = sizeof(*rec) + nr_states * sizeof(rec->time_in_state[0]);
+
+	uid_bufs_fold();
+
+	spin_lock_irqsave(&uid_lock, flags);
+	gen = ++uid_stats_gen;
+	spin_unlock_irqrestore(&uid_lock, flags);
+
+retry:
+	alloc_nr = 0;
+	rcu_read_lock();
+	hash_for_each_rcu(uid_hash_table, bkt, uid_entry, hash)
+		alloc_nr++;
+	rcu_read_unlock();
+
+	vfree(bin->buf);
+	bin->len = 0;
+	bin->buf = vzalloc(sizeof(*hdr) + alloc_nr * rec_size);
+	if (!bin->buf)
+		return -ENOMEM;
+
+	hdr = bin->buf;
+	rec = (struct uid_time_in_state_record *)(hdr + 1);
+	nr = 0;
+
+	rcu_read_lock();
+	hash_for_each_rcu(uid_hash_table, bkt, uid_entry, hash) {
+		if (!uid_entry->max_state ||
+		    READ_ONCE(uid_entry->gen) <= bin->last_gen)
+			continue;
+
+		if (nr == alloc_nr) {
+			/* UIDs were added since we counted them */
+			rcu_read_unlock();
+			goto retry;
+		}
+
+		/* raw cputime for now, converted below */
+		rec->uid = uid_entry->uid;
+		max_state = min(uid_entry->max_state, nr_states);
+		for (i = 0; i < max_state; i++)
+			rec->time_in_state[i] = uid_entry->time_in_state[i];
+
+		rec = (void *)rec + rec_size;
+		nr++;
+	}
+	rcu_read_unlock();
+
+	rec = (struct uid_time_in_state_record *)(hdr + 1);
+	for (hdr->nr_records = 0; hdr->nr_records < nr; hdr->nr_records++) {
+		for (i = 0; i < nr_states; i++)
+			rec->time_in_state[i] =
+				cputime_to_clock_t(rec->time_in_state[i]);
+		rec = (void *)rec + rec_size;
+	}
+
+	hdr->magic = UID_STATS_MAGIC;
+	hdr->version = UID_STATS_VERSION;
+	hdr->flags = bin->last_gen ? UID_STATS_DELTA : 0;
+	hdr->record_size = rec_size;
+	hdr->nr_states = nr_states;
+	hdr->generation = gen;
+
+	bin->len = sizeof(*hdr) + hdr->nr_records * rec_size;
+	bin->last_gen = gen;
+
+	return 0;
+}
+
+static int uid_time_in_state_bin_open(struct inode *inode, struct file *file)
+{
+	struct uid_stats_bin *bin;
+
+	bin = kzalloc(sizeof(*bin), GFP_KERNEL);
+	if (!bin)
+		return -ENOMEM;
+
+	mutex_init(&bin->lock);
+	file->private_data = bin;
+
+	return 0;
+}
+
+static ssize_t uid_time_in_state_bin_read(struct file *file, char __user *buf,
+					  size_t count, loff_t *ppos)
+{
+	struct uid_stats_bin *bin = file->private_data;
+	ssize_t ret;
+
+	mutex_lock(&bin->lock);
+
+	/* Every read from the start is a new snapshot */
+	if (*ppos == 0) {
+		ret = uid_time_in_state_bin_snapshot(bin);
+		if (ret)
+			goto out;
+	}
+
+	ret = simple_read_from_buffer(buf, count, ppos, bin->buf, bin->len);
+out:
+	mutex_unlock(&bin->lock);
+	return ret;
+}
+
+static int uid_time_in_state_bin_release(struct inode *inode,
+					 struct file *file)
+{
+	struct uid_stats_bin *bin = file->private_data;
+
+	vfree(bin->buf);
+	kfree(bin);
+
+	return 0;
+}
+
+static const struct file_operations uid_time_in_state_bin_fops = {
+	.open		= uid_time_in_state_bin_open,
+	.read		= uid_time_in_state_bin_read,
+	.llseek		= default_llseek,
+	.release	= uid_time_in_state_bin_release,
+};
+
 static const struct seq_operations uid_time_in_state_seq_ops = {
 	.start = uid_seq_start,
 	.next = uid_seq_next,
@@ -618,8 +943,172 @@ static const struct file_operations concurrent_policy_time_fops = {
 	.release	= seq_release,
 };
 
+#ifdef CONFIG_CPU_FREQ_TIMES_SELFTEST
+/*
+ * Boot-time check that the per-cpu buffers lose nothing. A writer on each
+ * online cpu accounts times for more test UIDs than a buffer has slots,
+ * and also adds them to a reference under a single lock, as all accounting
+ * used to go through uid_lock. Another thread keeps folding meanwhile.
+ * Once the writers are done, the folded uid_entry times must match the
+ * reference.
+ */
+#define UID_BUF_TEST_UID	0x7fff0000
+#define UID_BUF_TEST_UIDS	(UID_BUF_SLOTS * 4)
+#define UID_BUF_TEST_STATES	4
+#define UID_BUF_TEST_LOOPS	20000
+
+struct uid_buf_test {
+	spinlock_t lock;
+	unsigned int nr_states;
+	int policy;
+	u64 time_in_state[UID_BUF_TEST_UIDS][UID_BUF_TEST_STATES];
+	u64 active[UID_BUF_TEST_UIDS];
+	u64 policy_time[UID_BUF_TEST_UIDS];
+};
+
+struct uid_buf_test_writer {
+	struct uid_buf_test *test;
+	struct completion done;
+};
+
+static int uid_buf_test_write(void *data)
+{
+	struct uid_buf_test_writer *writer = data;
+	struct uid_buf_test *test = writer->test;
+	unsigned int i, u, state;
+	unsigned long flags;
+	u64 time;
+
+	for (i = 0; i < UID_BUF_TEST_LOOPS; i++) {
+		u = i % UID_BUF_TEST_UIDS;
+		state = test->nr_states ? i % test->nr_states : UINT_MAX;
+		time = 1 + i % 7;
+
+		uid_buf_add(UID_BUF_TEST_UID + u, state, 0, test->policy,
+			    (__force cputime_t)time);
+
+		spin_lock_irqsave(&test->lock, flags);
+		if (state < test->nr_states)
+			test->time_in_state[u][state] += time;
+		test->active[u] += time;
+		test->policy_time[u] += time;
+		spin_unlock_irqrestore(&test->lock, flags);
+
+		if (!(i % 64))
+			cond_resched();
+	}
+
+	complete(&writer->done);
+	return 0;
+}
+
+static int uid_buf_test_fold(void *data)
+{
+	while (!kthread_should_stop()) {
+		uid_bufs_fold();
+		cond_resched();
+	}
+	return 0;
+}
+
+static bool __init uid_buf_test_check(struct uid_buf_test *test)
+{
+	struct concurrent_times *times;
+	struct uid_entry *uid_entry;
+	unsigned int u, s;
+	bool same, ok = true;
+
+	rcu_read_lock();
+	for (u = 0; u < UID_BUF_TEST_UIDS; u++) {
+		uid_entry = find_uid_entry_rcu(UID_BUF_TEST_UID + u);
+		if (!uid_entry) {
+			pr_err("uid_buf test: uid %u missing\n",
+			       UID_BUF_TEST_UID + u);
+			ok = false;
+			continue;
+		}
+
+		times = uid_entry->concurrent_times;
+		same = atomic64_read(&times->active[0]) == test->active[u] &&
+			atomic64_read(&times->policy[test->policy]) ==
+			test->policy_time[u];
+		for (s = 0; s < test->nr_states; s++)
+			if (uid_entry->time_in_state[s] !=
+			    test->time_in_state[u][s])
+				same = false;
+
+		if (!same) {
+			pr_err("uid_buf test: uid %u differs from the reference\n",
+			       UID_BUF_TEST_UID + u);
+			ok = false;
+		}
+	}
+	rcu_read_unlock();
+
+	return ok;
+}
+
+static int __init uid_buf_selftest(void)
+{
+	struct uid_buf_test_writer *writers;
+	struct task_struct *folder, *t;
+	struct uid_buf_test *test;
+	int cpu, i, nr = 0;
+	bool ok;
+
+	test = kzalloc(sizeof(*test), GFP_KERNEL);
+	writers = kcalloc(nr_cpu_ids, sizeof(*writers), GFP_KERNEL);
+	if (!test || !writers)
+		goto out;
+
+	spin_lock_init(&test->lock);
+	test->nr_states = min_t(unsigned int, READ_ONCE(next_offset),
+				UID_BUF_TEST_STATES);
+	test->policy = nr_cpu_ids - 1;
+
+	folder = kthread_run(uid_buf_test_fold, NULL, "uid_buf_fold");
+	if (IS_ERR(folder))
+		goto out;
+
+	for_each_online_cpu(cpu) {
+		writers[nr].test = test;
+		init_completion(&writers[nr].done);
+		t = kthread_create(uid_buf_test_write, &writers[nr],
+				   "uid_buf_test/%d", cpu);
+		if (IS_ERR(t))
+			continue;
+		kthread_bind(t, cpu);
+		wake_up_process(t);
+		nr++;
+	}
+
+	for (i = 0; i < nr; i++)
+		wait_for_completion(&writers[i].done);
+	kthread_stop(folder);
+
+	uid_bufs_fold();
+	ok = uid_buf_test_check(test);
+	cpufreq_task_times_remove_uids(UID_BUF_TEST_UID,
+				       UID_BUF_TEST_UID + UID_BUF_TEST_UIDS - 1);
+
+	if (ok)
+		pr_info("uid_buf test: %d writers passed\n", nr);
+	WARN_ON(!ok);
+out:
+	kfree(writers);
+	kfree(test);
+	return 0;
+}
+late_initcall(uid_buf_selftest);
+#endif
+
 static int __init cpufreq_times_init(void)
 {
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu(uid_bufs, cpu).lock);
+
 	proc_create_data("uid_time_in_state", 0444, NULL,
 			 &uid_time_in_state_fops, NULL);
 
@@ -629,6 +1118,9 @@ static int __init cpufreq_times_init(void)
 	proc_create_data("uid_concurrent_policy_time", 0444, NULL,
 			 &concurrent_policy_time_fops, NULL);
 
+	proc_create_data("uid_time_in_state_bin", 0444, NULL,
+			 &uid_time_in_state_bin_fops, NULL);
+
 	return 0;
 }
 
@@ -12,6 +12,8 @@
 #include "dm-verity-fec.h"
 #include <linux/math64.h>
 #include <linux/sysfs.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
 
 #define DM_MSG_PREFIX	"verity-fec"
 
@@ -44,10 +46,11 @@ static inline u64 fec_interleave(struct dm_verity *v, u64 offset)
 }
 
 /*
- * Decode an RS block using Reed-Solomon.
+ * Decode an RS block using Reed-Solomon. decode_rs8 writes the error
+ * locations it finds to @erasures.
  */
 static int fec_decode_rs8(struct dm_verity *v, struct dm_verity_fec_io *fio,
-			  u8 *data, u8 *fec, int neras)
+			  u8 *data, u8 *fec, int neras, int *erasures)
 {
 	int i;
 	uint16_t par[DM_VERITY_FEC_RSM - DM_VERITY_FEC_MIN_RSN];
@@ -56,7 +59,7 @@ static int fec_decode_rs8(struct dm_verity *v, struct dm_verity_fec_io *fio,
 		par[i] = fec[i];
 
 	return decode_rs8(fio->rs, data, par, v->fec->rsn, NULL, neras,
-			  fio->erasures, 0, NULL);
+			  erasures, 0, NULL);
 }
 
 /*
@@ -123,29 +126,36 @@ static inline unsigned fec_buffer_rs_index(unsigned i, unsigned j)
 }
 
 /*
- * Decode all RS blocks from buffers and copy corrected bytes into fio->output
- * starting from block_offset.
+ * Decode @count RS blocks from buffers, starting from RS block @first, and
+ * copy corrected bytes into fio->output starting from block_offset + @first.
+ * Returns the number of corrected errors.
  */
-static int fec_decode_bufs(struct dm_verity *v, struct dm_verity_fec_io *fio,
-			   u64 rsb, int byte_index, unsigned block_offset,
-			   int neras)
+static int fec_decode_range(struct dm_verity *v, struct dm_verity_fec_io *fio,
+			    u64 rsb, int byte_index, unsigned block_offset,
+			    unsigned first, unsigned count, int neras,
+			    int *erasures)
 {
 	int r, corrected = 0, res;
 	struct dm_buffer *buf;
-	unsigned n, i, offset;
+	unsigned k, offset;
 	u8 *par, *block;
 
+	block_offset += first;
+
 	par = fec_read_parity(v, rsb, block_offset, &offset, &buf);
 	if (IS_ERR(par))
 		return PTR_ERR(par);
 
 	/*
-	 * Decode the RS blocks we have in bufs. Each RS block results in
-	 * one corrected target byte and consumes fec->roots parity bytes.
+	 * Each RS block results in one corrected target byte and consumes
+	 * fec->roots parity bytes.
 	 */
-	fec_for_each_buffer_rs_block(fio, n, i) {
-		block = fec_buffer_rs_block(v, fio, n, i);
-		res = fec_decode_rs8(v, fio, block, &par[offset], neras);
+	for (k = first; k < first + count; k++) {
+		block = fec_buffer_rs_block(v, fio,
+				k >> DM_VERITY_FEC_BUF_RS_BITS,
+				k & ((1 << DM_VERITY_FEC_BUF_RS_BITS) - 1));
+		res = fec_decode_rs8(v, fio, block, &par[offset], neras,
+				     erasures);
 		if (res < 0) {
 			r = res;
 			goto error;
@@ -155,8 +165,8 @@ static int fec_decode_bufs(struct dm_verity *v, struct dm_verity_fec_io *fio,
 		fio->output[block_offset] = block[byte_index];
 
 		block_offset++;
-		if (block_offset >= 1 << v->data_dev_block_bits)
-			goto done;
+		if (k + 1 == first + count)
+			break;
 
 		/* read the next block when we run out of parity bytes */
 		offset += v->fec->roots;
@@ -168,10 +178,98 @@ static int fec_decode_bufs(struct dm_verity *v, struct dm_verity_fec_io *fio,
 				return PTR_ERR(par);
 		}
 	}
-done:
+
 	r = corrected;
 error:
 	dm_bufio_release(buf);
+	return r;
+}
+
+struct fec_decode_work {
+	struct work_struct work;
+	struct dm_verity *v;
+	struct dm_verity_fec_io *fio;
+	u64 rsb;
+	int byte_index;
+	unsigned block_offset;
+	unsigned first;
+	unsigned count;
+	int neras;
+	int erasures[DM_VERITY_FEC_MAX_RSN];	/* private copy */
+	int r;
+};
+
+static void fec_decode_work(struct work_struct *work)
+{
+	struct fec_decode_work *dw =
+		container_of(work, struct fec_decode_work, work);
+
+	dw->r = fec_decode_range(dw->v, dw->fio, dw->rsb, dw->byte_index,
+				 dw->block_offset, dw->first, dw->count,
+				 dw->neras, dw->erasures);
+}
+
+/*
+ * Decode all RS blocks from buffers and copy corrected bytes into fio->output
+ * starting from block_offset.
+ *
+ * The RS blocks are independent of each other, so when there are enough of
+ * them they are split between the caller and up to
+ * DM_VERITY_FEC_DECODE_MAX_CPUS - 1 workers on fec->decode_wq.
+ */
+static int fec_decode_bufs(struct dm_verity *v, struct dm_verity_fec_io *fio,
+			   u64 rsb, int byte_index, unsigned block_offset,
+			   int neras)
+{
+	struct fec_decode_work *works = NULL;
+	unsigned total, per, nr = 1, i;
+	int r;
+
+	total = min(fio->nbufs << DM_VERITY_FEC_BUF_RS_BITS,
+		    (1U << v->data_dev_block_bits) - block_offset);
+
+	if (total >= 2 * DM_VERITY_FEC_DECODE_MIN_RS) {
+		nr = min3(total / DM_VERITY_FEC_DECODE_MIN_RS,
+			  (unsigned)DM_VERITY_FEC_DECODE_MAX_CPUS,
+			  num_online_cpus());
+		if (nr > 1) {
+			works = kmalloc_array(nr - 1, sizeof(*works),
+					      GFP_NOIO | __GFP_NORETRY |
+					      __GFP_NOWARN);
+			if (!works)
+				nr = 1;
+		}
+	}
+
+	per = DIV_ROUND_UP(total, nr);
+
+	for (i = 1; i < nr; i++) {
+		struct fec_decode_work *dw = &works[i - 1];
+
+		INIT_WORK(&dw->work, fec_decode_work);
+		dw->v = v;
+		dw->fio = fio;
+		dw->rsb = rsb;
+		dw->byte_index = byte_index;
+		dw->block_offset = block_offset;
+		dw->first = i * per;
+		dw->count = min(per, total - dw->first);
+		dw->neras = neras;
+		memcpy(dw->erasures, fio->erasures, sizeof(dw->erasures));
+		queue_work(v->fec->decode_wq, &dw->work);
+	}
+
+	r = fec_decode_range(v, fio, rsb, byte_index, block_offset, 0,
+			     min(per, total), neras, fio->erasures);
+
+	for (i = 1; i < nr; i++) {
+		struct fec_decode_work *dw = &works[i - 1];
+
+		flush_work(&dw->work);
+		if (r >= 0)
+			r = dw->r < 0 ? dw->r : r + dw->r;
+	}
+	kfree(works);
 
 	if (r < 0 && neras)
 		DMERR_LIMIT("%s: FEC %llu: failed to correct: %d",
@@ -416,6 +514,51 @@ static int fec_decode_rsb(struct dm_verity *v, struct dm_verity_io *io,
 	return 0;
 }
 
+/*
+ * Copy a recently corrected @block into fio->output. Returns false if it is
+ * not in the cache.
+ */
+static bool fec_cache_lookup(struct dm_verity *v, struct dm_verity_fec_io *fio,
+			     sector_t block)
+{
+	struct dm_verity_fec *f = v->fec;
+	bool found = false;
+	unsigned i;
+
+	spin_lock(&f->corrected_lock);
+	for (i = 0; i < DM_VERITY_FEC_CACHE_SIZE; i++) {
+		if (f->corrected_block[i] != block)
+			continue;
+
+		memcpy(fio->output,
+		       f->corrected_data + (i << v->data_dev_block_bits),
+		       1 << v->data_dev_block_bits);
+		found = true;
+		break;
+	}
+	spin_unlock(&f->corrected_lock);
+
+	return found;
+}
+
+/*
+ * Remember the corrected @block in fio->output, replacing the oldest entry.
+ */
+static void fec_cache_insert(struct dm_verity *v, struct dm_verity_fec_io *fio,
+			     sector_t block)
+{
+	struct dm_verity_fec *f = v->fec;
+	unsigned i;
+
+	spin_lock(&f->corrected_lock);
+	i = f->corrected_next;
+	f->corrected_next = (i + 1) % DM_VERITY_FEC_CACHE_SIZE;
+	f->corrected_block[i] = block;
+	memcpy(f->corrected_data + (i << v->data_dev_block_bits),
+	       fio->output, 1 << v->data_dev_block_bits);
+	spin_unlock(&f->corrected_lock);
+}
+
 static int fec_bv_copy(struct dm_verity *v, struct dm_verity_io *io, u8 *data,
 		       size_t len)
 {
@@ -452,6 +595,18 @@ int verity_fec_decode(struct dm_verity *v, struct dm_verity_io *io,
 	if (type == DM_VERITY_BLOCK_TYPE_METADATA)
 		block = block - v->hash_start + v->data_blocks;
 
+	/*
+	 * A corrupted block tends to be read again soon, e.g. by readahead
+	 * and then by the actual read, so don't decode it twice. The tree
+	 * never changes, so a block that matched its hash once still does.
+	 */
+	if (!fio->output)
+		fio->output = mempool_alloc(v->fec->output_pool, GFP_NOIO);
+	if (fec_cache_lookup(v, fio, block)) {
+		r = 0;
+		goto copy;
+	}
+
 	/*
 	 * For RS(M, N), the continuous FEC data is divided into blocks of N
 	 * bytes. Since block size may not be divisible by N, the last block
@@ -483,6 +638,9 @@ int verity_fec_decode(struct dm_verity *v, struct dm_verity_io *io,
 			goto done;
 	}
 
+	fec_cache_insert(v, fio, block);
+
+copy:
 	if (dest)
 		memcpy(dest, fio->output, 1 << v->data_dev_block_bits);
 	else if (iter) {
@@ -570,6 +728,10 @@ void verity_fec_dtr(struct dm_verity *v)
 	mempool_destroy(f->output_pool);
 	kmem_cache_destroy(f->cache);
 
+	if (f->decode_wq)
+		destroy_workqueue(f->decode_wq);
+	vfree(f->corrected_data);
+
 	if (f->data_bufio)
 		dm_bufio_client_destroy(f->data_bufio);
 	if (f->bufio)
@@ -716,7 +878,7 @@ int verity_fec_ctr_alloc(struct dm_verity *v)
  */
 int verity_fec_ctr(struct dm_verity *v)
 {
-	int r;
+	int r, i;
 	struct dm_verity_fec *f = v->fec;
 	struct dm_target *ti = v->ti;
 	struct mapped_device *md = dm_table_get_md(ti->table);
@@ -864,6 +1026,25 @@ int verity_fec_ctr(struct dm_verity *v)
 		return -ENOMEM;
 	}
 
+	/* RS decoding of a corrupted block is spread over a few CPUs */
+	f->decode_wq = alloc_workqueue("dm_verity_fec", WQ_UNBOUND |
+				       WQ_HIGHPRI | WQ_MEM_RECLAIM,
+				       DM_VERITY_FEC_DECODE_MAX_CPUS);
+	if (!f->decode_wq) {
+		ti->error = "Cannot allocate FEC decode workqueue";
+		return -ENOMEM;
+	}
+
+	f->corrected_data = vmalloc(DM_VERITY_FEC_CACHE_SIZE <<
+				    v->data_dev_block_bits);
+	if (!f->corrected_data) {
+		ti->error = "Cannot allocate FEC corrected block cache";
+		return -ENOMEM;
+	}
+	spin_lock_init(&f->corrected_lock);
+	for (i = 0; i < DM_VERITY_FEC_CACHE_SIZE; i++)
+		f->corrected_block[i] = ~(sector_t)0;
+
 	/* Reserve space for our per-bio data */
 	ti->per_io_data_size += sizeof(struct dm_verity_fec_io);
 
@@ -32,6 +32,14 @@
 /* maximum recursion level for verity_fec_decode */
 #define DM_VERITY_FEC_MAX_RECURSION	4
 
+/* RS blocks are decoded on at most this many CPUs at once */
+#define DM_VERITY_FEC_DECODE_MAX_CPUS	4
+/* with at least this many RS blocks for each of them */
+#define DM_VERITY_FEC_DECODE_MIN_RS	256
+
+/* number of recently corrected blocks to keep */
+#define DM_VERITY_FEC_CACHE_SIZE	8
+
 #define DM_VERITY_OPT_FEC_DEV		"use_fec_from_device"
 #define DM_VERITY_OPT_FEC_BLOCKS	"fec_blocks"
 #define DM_VERITY_OPT_FEC_START		"fec_start"
@@ -53,6 +61,11 @@ struct dm_verity_fec {
 	mempool_t *extra_pool;	/* mempool for extra buffers */
 	mempool_t *output_pool;	/* mempool for output */
 	struct kmem_cache *cache;	/* cache for buffers */
+	struct workqueue_struct *decode_wq;	/* for parallel RS decoding */
+	spinlock_t corrected_lock;	/* protects the corrected_* cache */
+	u8 *corrected_data;	/* recently corrected blocks */
+	sector_t corrected_block[DM_VERITY_FEC_CACHE_SIZE];
+	unsigned corrected_next;	/* cache slot to replace next */
 	atomic_t corrected;		/* corrected errors */
 	struct dm_kobject_holder kobj_holder;	/* for sysfs attributes */
 };
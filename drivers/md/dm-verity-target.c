@@ -9,15 +9,17 @@
  *
  * In the file "/sys/module/dm_verity/parameters/prefetch_cluster" you can set
  * default prefetch value. Data are read in "prefetch_cluster" chunks from the
- * hash device. Setting this greatly improves performance when data and hash
- * are on the same disk on different partitions on devices with poor random
- * access behavior.
+ * hash device, and sequential reads prefetch up to "prefetch_cluster" further
+ * ahead, growing as the stream goes on. Setting this greatly improves
+ * performance when data and hash are on the same disk on different
+ * partitions on devices with poor random access behavior.
  */
 
 #include "dm-verity.h"
 #include "dm-verity-fec.h"
 
 #include <linux/delay.h>
+#include <linux/highmem.h>
 #include <linux/module.h>
 #include <linux/reboot.h>
 #include <linux/vmalloc.h>
@@ -31,13 +33,16 @@
 
 #define DM_VERITY_MAX_CORRUPTED_ERRS	100
 
+#define DM_VERITY_MAX_PINNED_BLOCKS	256
+
 #define DM_VERITY_OPT_DEVICE_WAIT	"device_wait"
 #define DM_VERITY_OPT_LOGGING		"ignore_corruption"
 #define DM_VERITY_OPT_RESTART		"restart_on_corruption"
 #define DM_VERITY_OPT_IGN_ZEROES	"ignore_zero_blocks"
 #define DM_VERITY_OPT_AT_MOST_ONCE	"check_at_most_once"
+#define DM_VERITY_OPT_AT_MOST_ONCE_EPOCH "check_at_most_once_epoch"
 
-#define DM_VERITY_OPTS_MAX		(3 + DM_VERITY_OPTS_FEC)
+#define DM_VERITY_OPTS_MAX		(5 + DM_VERITY_OPTS_FEC)
 
 static unsigned dm_verity_prefetch_cluster = DM_VERITY_DEFAULT_PREFETCH_SIZE;
 
@@ -50,6 +55,7 @@ struct dm_verity_prefetch_work {
 	struct dm_verity *v;
 	sector_t block;
 	unsigned n_blocks;
+	unsigned window;	/* lowest level hash blocks to read ahead */
 };
 
 /*
@@ -249,6 +255,26 @@ static int verity_handle_err(struct dm_verity *v, enum verity_block_type type,
 	return 1;
 }
 
+/*
+ * Take an extra hold on a verified buffer of the upper tree levels, so that
+ * dm-bufio never evicts it. These levels are small and every lookup that
+ * misses the lowest level goes through them.
+ */
+static void verity_pin_buffer(struct dm_verity *v, sector_t hash_block)
+{
+	struct dm_buffer **slot = &v->pinned[hash_block - v->hash_start];
+	struct dm_buffer *buf;
+
+	if (likely(READ_ONCE(*slot)))
+		return;
+
+	if (IS_ERR_OR_NULL(dm_bufio_get(v->bufio, hash_block, &buf)))
+		return;
+
+	if (cmpxchg(slot, NULL, buf))
+		dm_bufio_release(buf);
+}
+
 /*
  * Verify hash of a metadata block pertaining to the specified data block
  * ("block" argument) at a specified level ("level" argument).
@@ -273,7 +299,13 @@ static int verity_verify_level(struct dm_verity *v, struct dm_verity_io *io,
 
 	verity_hash_at_level(v, block, level, &hash_block, &offset);
 
-	data = dm_bufio_read(v->bufio, hash_block, &buf);
+	data = dm_bufio_get(v->bufio, hash_block, &buf);
+	if (likely(data)) {
+		atomic64_inc(&v->level_hits[level]);
+	} else {
+		atomic64_inc(&v->level_misses[level]);
+		data = dm_bufio_read(v->bufio, hash_block, &buf);
+	}
 	if (IS_ERR(data))
 		return PTR_ERR(data);
 
@@ -306,6 +338,9 @@ static int verity_verify_level(struct dm_verity *v, struct dm_verity_io *io,
 		}
 	}
 
+	if (aux->hash_verified && hash_block - v->hash_start < v->nr_pinned)
+		verity_pin_buffer(v, hash_block);
+
 	data += offset;
 	memcpy(want_digest, data, v->digest_size);
 	r = 0;
@@ -416,32 +451,167 @@ static inline void verity_bv_skip_block(struct dm_verity *v,
 	bio_advance_iter(bio, iter, 1 << v->data_dev_block_bits);
 }
 
+/*
+ * Hash the data blocks queued in io->pending with one call and check each of
+ * them against its expected digest.
+ */
+static int verity_verify_pending_blocks(struct dm_verity *v,
+					struct dm_verity_io *io)
+{
+	struct shash_desc *desc = verity_io_hash_desc(v, io);
+	const u8 *data[DM_VERITY_MAX_PENDING_BLOCKS];
+	u8 *digests[DM_VERITY_MAX_PENDING_BLOCKS];
+	unsigned i, n = io->num_pending;
+	int r;
+
+	if (!n)
+		return 0;
+
+	for (i = 0; i < n; i++) {
+		data[i] = io->pending[i].data;
+		digests[i] = io->pending[i].real_digest;
+	}
+
+	r = verity_hash_init(v, desc);
+	if (likely(r >= 0)) {
+		r = crypto_shash_finup_mb(desc, data,
+					  1 << v->data_dev_block_bits,
+					  digests, n);
+		if (unlikely(r < 0))
+			DMERR("crypto_shash_finup_mb failed: %d", r);
+	}
+
+	for (i = 0; i < n; i++)
+		kunmap(io->pending[i].page);
+	io->num_pending = 0;
+
+	if (unlikely(r < 0))
+		return r;
+
+	for (i = 0; i < n; i++) {
+		struct dm_verity_pending_block *p = &io->pending[i];
+
+		if (likely(memcmp(p->real_digest, p->want_digest,
+				  v->digest_size) == 0)) {
+			if (v->validated_blocks)
+				set_bit(p->block, v->validated_blocks);
+			continue;
+		}
+
+		/* FEC checks its result against the io's own want digest */
+		memcpy(verity_io_want_digest(v, io), p->want_digest,
+		       v->digest_size);
+		if (verity_fec_decode(v, io, DM_VERITY_BLOCK_TYPE_DATA,
+				      p->block, NULL, &p->start) == 0)
+			continue;
+		else if (verity_handle_err(v, DM_VERITY_BLOCK_TYPE_DATA,
+					   p->block))
+			return -EIO;
+	}
+
+	return 0;
+}
+
+/*
+ * Return true if the data block at io->iter is contiguous in memory and can
+ * be queued for verity_verify_pending_blocks().
+ */
+static bool verity_block_can_queue(struct dm_verity *v,
+				   struct dm_verity_io *io)
+{
+	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+	struct bio_vec bv = bio_iter_iovec(bio, io->iter);
+
+	return bv.bv_len >= 1 << v->data_dev_block_bits;
+}
+
+/*
+ * Queue the data block at io->iter for verity_verify_pending_blocks(). The
+ * caller has checked verity_block_can_queue().
+ */
+static void verity_queue_pending_block(struct dm_verity *v,
+				       struct dm_verity_io *io,
+				       sector_t block)
+{
+	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+	struct bio_vec bv = bio_iter_iovec(bio, io->iter);
+	struct dm_verity_pending_block *p;
+
+	p = &io->pending[io->num_pending++];
+	p->page = bv.bv_page;
+	p->data = (u8 *)kmap(bv.bv_page) + bv.bv_offset;
+	p->block = block;
+	p->start = io->iter;
+	memcpy(p->want_digest, verity_io_want_digest(v, io), v->digest_size);
+
+	verity_bv_skip_block(v, io, &io->iter);
+}
+
+/*
+ * Forget which blocks were validated once the check_at_most_once_epoch has
+ * passed, so that every block is hashed again at least once per epoch.
+ */
+static void verity_expire_validated_blocks(struct dm_verity *v)
+{
+	unsigned long start = READ_ONCE(v->validated_epoch_start);
+
+	if (!v->validated_epoch ||
+	    time_before(jiffies, start + v->validated_epoch))
+		return;
+
+	/* Only one of the concurrent ios clears the bitset */
+	if (cmpxchg(&v->validated_epoch_start, start, jiffies) != start)
+		return;
+
+	bitmap_zero(v->validated_blocks, v->data_blocks);
+}
+
 /*
  * Verify one "dm_verity_io" structure.
  */
 static int verity_verify_io(struct dm_verity_io *io)
 {
-	bool is_zero;
+	bool is_zero, queue;
 	struct dm_verity *v = io->v;
 	struct bvec_iter start;
 	unsigned b;
+	unsigned validated_hits = 0;
+	int r;
+
+	io->num_pending = 0;
+
+	if (v->validated_blocks)
+		verity_expire_validated_blocks(v);
 
 	for (b = 0; b < io->n_blocks; b++) {
-		int r;
 		sector_t cur_block = io->block + b;
 		struct shash_desc *desc = verity_io_hash_desc(v, io);
 
 		if (v->validated_blocks &&
 		    likely(test_bit(cur_block, v->validated_blocks))) {
 			verity_bv_skip_block(v, io, &io->iter);
+			validated_hits++;
 			continue;
 		}
 
+		queue = v->mb_max_msgs > 1 && verity_block_can_queue(v, io);
+
+		/*
+		 * Hash the queued blocks before a block that can't join them.
+		 * A mismatch among them reuses the io's want digest for FEC,
+		 * so this has to happen before this block's digest is loaded.
+		 */
+		if (!queue && io->num_pending) {
+			r = verity_verify_pending_blocks(v, io);
+			if (unlikely(r < 0))
+				goto out;
+		}
+
 		r = verity_hash_for_block(v, io, cur_block,
 					  verity_io_want_digest(v, io),
 					  &is_zero);
 		if (unlikely(r < 0))
-			return r;
+			goto out;
 
 		if (is_zero) {
 			/*
@@ -451,23 +621,33 @@ static int verity_verify_io(struct dm_verity_io *io)
 			r = verity_for_bv_block(v, io, &io->iter,
 						verity_bv_zero);
 			if (unlikely(r < 0))
-				return r;
+				goto out;
 
 			continue;
 		}
 
+		if (queue) {
+			verity_queue_pending_block(v, io, cur_block);
+			if (io->num_pending < v->mb_max_msgs)
+				continue;
+			r = verity_verify_pending_blocks(v, io);
+			if (unlikely(r < 0))
+				goto out;
+			continue;
+		}
+
 		r = verity_hash_init(v, desc);
 		if (unlikely(r < 0))
-			return r;
+			goto out;
 
 		start = io->iter;
 		r = verity_for_bv_block(v, io, &io->iter, verity_bv_hash_update);
 		if (unlikely(r < 0))
-			return r;
+			goto out;
 
 		r = verity_hash_final(v, desc, verity_io_real_digest(v, io));
 		if (unlikely(r < 0))
-			return r;
+			goto out;
 
 		if (likely(memcmp(verity_io_real_digest(v, io),
 				  verity_io_want_digest(v, io), v->digest_size) == 0)) {
@@ -479,11 +659,24 @@ static int verity_verify_io(struct dm_verity_io *io)
 					   cur_block, NULL, &start) == 0)
 			continue;
 		else if (verity_handle_err(v, DM_VERITY_BLOCK_TYPE_DATA,
-					   cur_block))
-			return -EIO;
+					   cur_block)) {
+			r = -EIO;
+			goto out;
+		}
 	}
 
-	return 0;
+	r = verity_verify_pending_blocks(v, io);
+out:
+	/* unmap whatever is still queued after an error */
+	while (io->num_pending)
+		kunmap(io->pending[--io->num_pending].page);
+
+	if (v->validated_blocks) {
+		atomic64_add(validated_hits, &v->validated_hits);
+		atomic64_add(b - validated_hits, &v->validated_misses);
+	}
+
+	return r;
 }
 
 /*
@@ -522,49 +715,127 @@ static void verity_end_io(struct bio *bio)
 	queue_work(io->v->verify_wq, &io->work);
 }
 
+/*
+ * Return true if all lowest level hash blocks in the range are cached, in
+ * which case the upper levels are not needed either.
+ */
+static bool verity_prefetch_cached(struct dm_verity *v, sector_t hash_block,
+				   sector_t hash_block_end)
+{
+	struct dm_buffer *buf;
+
+	for (; hash_block <= hash_block_end; hash_block++) {
+		if (IS_ERR_OR_NULL(dm_bufio_get(v->bufio, hash_block, &buf)))
+			return false;
+		dm_bufio_release(buf);
+	}
+
+	return true;
+}
+
 /*
  * Prefetch buffers for the specified io.
  * The root buffer is not prefetched, it is assumed that it will be cached
  * all the time.
+ *
+ * The lowest level is always read in prefetch_cluster aligned chunks, and
+ * sequential streams also read pw->window hash blocks beyond that. If the
+ * chunk of a random read is already cached, nothing is prefetched.
  */
 static void verity_prefetch_io(struct work_struct *work)
 {
 	struct dm_verity_prefetch_work *pw =
 		container_of(work, struct dm_verity_prefetch_work, work);
 	struct dm_verity *v = pw->v;
+	sector_t start0, end0;
+	unsigned cluster;
 	int i;
 
+	verity_hash_at_level(v, pw->block, 0, &start0, NULL);
+	verity_hash_at_level(v, pw->block + pw->n_blocks - 1, 0, &end0, NULL);
+
+	cluster = ACCESS_ONCE(dm_verity_prefetch_cluster);
+	cluster >>= v->data_dev_block_bits;
+	if (likely(cluster)) {
+		if (unlikely(cluster & (cluster - 1)))
+			cluster = 1 << __fls(cluster);
+
+		start0 &= ~(sector_t)(cluster - 1);
+		end0 |= cluster - 1;
+	}
+	end0 += pw->window;
+	if (unlikely(end0 >= v->hash_blocks))
+		end0 = v->hash_blocks - 1;
+
+	if (!pw->window && v->levels && verity_prefetch_cached(v, start0, end0))
+		goto out;
+
 	for (i = v->levels - 2; i >= 0; i--) {
 		sector_t hash_block_start;
 		sector_t hash_block_end;
-		verity_hash_at_level(v, pw->block, i, &hash_block_start, NULL);
-		verity_hash_at_level(v, pw->block + pw->n_blocks - 1, i, &hash_block_end, NULL);
-		if (!i) {
-			unsigned cluster = ACCESS_ONCE(dm_verity_prefetch_cluster);
 
-			cluster >>= v->data_dev_block_bits;
-			if (unlikely(!cluster))
-				goto no_prefetch_cluster;
-
-			if (unlikely(cluster & (cluster - 1)))
-				cluster = 1 << __fls(cluster);
-
-			hash_block_start &= ~(sector_t)(cluster - 1);
-			hash_block_end |= cluster - 1;
-			if (unlikely(hash_block_end >= v->hash_blocks))
-				hash_block_end = v->hash_blocks - 1;
+		if (!i) {
+			hash_block_start = start0;
+			hash_block_end = end0;
+		} else {
+			verity_hash_at_level(v, pw->block, i,
+					     &hash_block_start, NULL);
+			verity_hash_at_level(v, pw->block + pw->n_blocks - 1, i,
+					     &hash_block_end, NULL);
 		}
-no_prefetch_cluster:
 		dm_bufio_prefetch(v->bufio, hash_block_start,
 				  hash_block_end - hash_block_start + 1);
 	}
 
+out:
 	kfree(pw);
 }
 
+/*
+ * Follow up to DM_VERITY_PREFETCH_STREAMS sequential streams, so that
+ * interleaved readers don't break each other's detection. An io continues
+ * the stream whose next expected block it starts at, and that stream's
+ * readahead window doubles up to prefetch_cluster. Any other io replaces
+ * the least recently used stream and gets no extra readahead.
+ */
+static unsigned verity_prefetch_window(struct dm_verity *v,
+				       struct dm_verity_io *io)
+{
+	struct dm_verity_stream *s, *lru = NULL;
+	unsigned cluster, window = 0;
+	int i;
+
+	spin_lock(&v->prefetch_lock);
+	v->prefetch_clock++;
+
+	for (i = 0; i < DM_VERITY_PREFETCH_STREAMS; i++) {
+		s = &v->prefetch_streams[i];
+		if (s->next == io->block)
+			break;
+		if (!lru || time_before(s->last_used, lru->last_used))
+			lru = s;
+	}
+
+	if (i < DM_VERITY_PREFETCH_STREAMS) {
+		cluster = ACCESS_ONCE(dm_verity_prefetch_cluster);
+		cluster >>= v->data_dev_block_bits;
+		window = min(max(2 * s->window, 1U), cluster);
+	} else {
+		s = lru;
+	}
+
+	s->next = io->block + io->n_blocks;
+	s->window = window;
+	s->last_used = v->prefetch_clock;
+	spin_unlock(&v->prefetch_lock);
+
+	return window;
+}
+
 static void verity_submit_prefetch(struct dm_verity *v, struct dm_verity_io *io)
 {
 	struct dm_verity_prefetch_work *pw;
+	unsigned window = verity_prefetch_window(v, io);
 
 	pw = kmalloc(sizeof(struct dm_verity_prefetch_work),
 		GFP_NOIO | __GFP_NORETRY | __GFP_NOMEMALLOC | __GFP_NOWARN);
@@ -576,6 +847,7 @@ static void verity_submit_prefetch(struct dm_verity *v, struct dm_verity_io *io)
 	pw->v = v;
 	pw->block = io->block;
 	pw->n_blocks = io->n_blocks;
+	pw->window = window;
 	queue_work(v->verify_wq, &pw->work);
 }
 
@@ -640,6 +912,17 @@ void verity_status(struct dm_target *ti, status_type_t type,
 	switch (type) {
 	case STATUSTYPE_INFO:
 		DMEMIT("%c", v->hash_failed ? 'C' : 'V');
+		DMEMIT(" %u", v->levels);
+		for (x = 0; x < v->levels; x++)
+			DMEMIT(" %llu %llu", (unsigned long long)
+			       atomic64_read(&v->level_hits[x]),
+			       (unsigned long long)
+			       atomic64_read(&v->level_misses[x]));
+		if (v->validated_blocks)
+			DMEMIT(" %llu %llu", (unsigned long long)
+			       atomic64_read(&v->validated_hits),
+			       (unsigned long long)
+			       atomic64_read(&v->validated_misses));
 		break;
 	case STATUSTYPE_TABLE:
 		DMEMIT("%u %s %s %u %u %llu %llu %s ",
@@ -668,6 +951,8 @@ void verity_status(struct dm_target *ti, status_type_t type,
 			args++;
 		if (v->validated_blocks)
 			args++;
+		if (v->validated_epoch)
+			args++;
 		if (!args)
 			return;
 		DMEMIT(" %u", args);
@@ -686,7 +971,11 @@ void verity_status(struct dm_target *ti, status_type_t type,
 		}
 		if (v->zero_digest)
 			DMEMIT(" " DM_VERITY_OPT_IGN_ZEROES);
-		if (v->validated_blocks)
+		if (v->validated_epoch)
+			DMEMIT(" " DM_VERITY_OPT_AT_MOST_ONCE_EPOCH " %u",
+			       jiffies_to_msecs(v->validated_epoch) /
+			       MSEC_PER_SEC);
+		else if (v->validated_blocks)
 			DMEMIT(" " DM_VERITY_OPT_AT_MOST_ONCE);
 		sz = verity_fec_status_table(v, sz, result, maxlen);
 		break;
@@ -738,6 +1027,15 @@ void verity_dtr(struct dm_target *ti)
 	if (v->verify_wq)
 		destroy_workqueue(v->verify_wq);
 
+	if (v->pinned) {
+		sector_t b;
+
+		for (b = 0; b < v->nr_pinned; b++)
+			if (v->pinned[b])
+				dm_bufio_release(v->pinned[b]);
+		vfree(v->pinned);
+	}
+
 	if (v->bufio)
 		dm_bufio_client_destroy(v->bufio);
 
@@ -783,6 +1081,67 @@ static int verity_alloc_most_once(struct dm_verity *v)
 	return 0;
 }
 
+static int verity_parse_most_once_epoch(struct dm_arg_set *as,
+					struct dm_verity *v, unsigned *argc)
+{
+	struct dm_target *ti = v->ti;
+	unsigned int num;
+	char dummy;
+	int r;
+
+	if (!*argc) {
+		ti->error = "Missing check_at_most_once_epoch value";
+		return -EINVAL;
+	}
+
+	if (sscanf(dm_shift_arg(as), "%u%c", &num, &dummy) != 1 || !num ||
+	    num > UINT_MAX / MSEC_PER_SEC) {
+		ti->error = "Invalid check_at_most_once_epoch";
+		return -EINVAL;
+	}
+	(*argc)--;
+
+	if (!v->validated_blocks) {
+		r = verity_alloc_most_once(v);
+		if (r)
+			return r;
+	}
+
+	v->validated_epoch = msecs_to_jiffies(num * MSEC_PER_SEC);
+	v->validated_epoch_start = jiffies;
+
+	return 0;
+}
+
+/*
+ * Allocate room to pin the upper levels of the tree, as many of them as fit
+ * in DM_VERITY_MAX_PINNED_BLOCKS. They are stored from hash_start on, the
+ * top level first.
+ */
+static int verity_alloc_pinned(struct dm_verity *v)
+{
+	sector_t nr = 0;
+	int i;
+
+	for (i = 1; i < v->levels; i++) {
+		if (v->hash_level_block[i - 1] - v->hash_start <=
+		    DM_VERITY_MAX_PINNED_BLOCKS) {
+			nr = v->hash_level_block[i - 1] - v->hash_start;
+			break;
+		}
+	}
+
+	if (!nr)
+		return 0;
+
+	v->pinned = vzalloc(nr * sizeof(*v->pinned));
+	if (!v->pinned)
+		return -ENOMEM;
+	v->nr_pinned = nr;
+
+	return 0;
+}
+
 static int verity_alloc_zero_digest(struct dm_verity *v)
 {
 	int r = -ENOMEM;
@@ -885,7 +1244,17 @@ static int verity_parse_opt_args(struct dm_arg_set *as, struct dm_verity *v)
 			continue;
 
 		} else if (!strcasecmp(arg_name, DM_VERITY_OPT_AT_MOST_ONCE)) {
-			r = verity_alloc_most_once(v);
+			/* check_at_most_once_epoch may have allocated it */
+			if (!v->validated_blocks) {
+				r = verity_alloc_most_once(v);
+				if (r)
+					return r;
+			}
+			continue;
+
+		} else if (!strcasecmp(arg_name,
+				       DM_VERITY_OPT_AT_MOST_ONCE_EPOCH)) {
+			r = verity_parse_most_once_epoch(as, v, &argc);
 			if (r)
 				return r;
 			continue;
@@ -938,6 +1307,7 @@ int verity_ctr(struct dm_target *ti, unsigned argc, char **argv)
 	}
 	ti->private = v;
 	v->ti = ti;
+	spin_lock_init(&v->prefetch_lock);
 
 	r = verity_fec_ctr_alloc(v);
 	if (r)
@@ -1070,6 +1440,15 @@ int verity_ctr(struct dm_target *ti, unsigned argc, char **argv)
 	v->shash_descsize =
 		sizeof(struct shash_desc) + crypto_shash_descsize(v->tfm);
 
+	/*
+	 * Data blocks can only be hashed together if the salt is a prefix,
+	 * which crypto_shash_finup_mb() shares between them.
+	 */
+	v->mb_max_msgs = 1;
+	if (v->version && v->digest_size <= DM_VERITY_MAX_DIGEST_SIZE)
+		v->mb_max_msgs = min_t(unsigned, DM_VERITY_MAX_PENDING_BLOCKS,
+				       crypto_shash_mb_max_msgs(v->tfm));
+
 	v->root_digest = kmalloc(v->digest_size, GFP_KERNEL);
 	if (!v->root_digest) {
 		ti->error = "Cannot allocate root digest";
@@ -1167,6 +1546,12 @@ int verity_ctr(struct dm_target *ti, unsigned argc, char **argv)
 		goto bad;
 	}
 
+	r = verity_alloc_pinned(v);
+	if (r) {
+		ti->error = "Cannot allocate pinned buffer array";
+		goto bad;
+	}
+
 	/* WQ_UNBOUND greatly improves performance when running on ramdisk */
 	v->verify_wq = alloc_workqueue("kverityd", WQ_CPU_INTENSIVE | WQ_MEM_RECLAIM | WQ_UNBOUND, num_online_cpus());
 	if (!v->verify_wq) {
@@ -1196,7 +1581,7 @@ EXPORT_SYMBOL_GPL(verity_ctr);
 
 static struct target_type verity_target = {
 	.name		= "verity",
-	.version	= {1, 4, 0},
+	.version	= {1, 5, 0},
 	.module		= THIS_MODULE,
 	.ctr		= verity_ctr,
 	.dtr		= verity_dtr,
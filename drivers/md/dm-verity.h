@@ -18,6 +18,13 @@
 
 #define DM_VERITY_MAX_LEVELS		63
 
+/* data blocks hashed together by one crypto_shash_finup_mb() call */
+#define DM_VERITY_MAX_PENDING_BLOCKS	2
+#define DM_VERITY_MAX_DIGEST_SIZE	64
+
+/* sequential read streams followed for hash prefetch */
+#define DM_VERITY_PREFETCH_STREAMS	8
+
 enum verity_mode {
 	DM_VERITY_MODE_EIO,
 	DM_VERITY_MODE_LOGGING,
@@ -31,6 +38,12 @@ enum verity_block_type {
 
 struct dm_verity_fec;
 
+struct dm_verity_stream {
+	sector_t next;		/* data block following the stream's last io */
+	unsigned window;	/* lowest level hash blocks to read ahead */
+	unsigned long last_used; /* prefetch_clock of the stream's last io */
+};
+
 struct dm_verity {
 	struct dm_dev *data_dev;
 	struct dm_dev *hash_dev;
@@ -53,6 +66,7 @@ struct dm_verity {
 	unsigned char version;
 	unsigned digest_size;	/* digest size for the current hash algorithm */
 	unsigned shash_descsize;/* the size of temporary space for crypto */
+	unsigned mb_max_msgs;	/* data blocks to hash together, 1 if none */
 	int hash_failed;	/* set to 1 if hash of any block failed */
 	enum verity_mode mode;	/* mode for handling verification errors */
 	unsigned corrupted_errs;/* Number of errors for corrupted blocks */
@@ -64,6 +78,33 @@ struct dm_verity {
 
 	struct dm_verity_fec *fec;	/* forward error correction */
 	unsigned long *validated_blocks; /* bitset blocks validated */
+	unsigned long validated_epoch;	/* jiffies between bitset resets */
+	unsigned long validated_epoch_start; /* jiffies of last reset */
+	atomic64_t validated_hits;	/* blocks skipped thanks to the bitset */
+	atomic64_t validated_misses;	/* blocks hashed while it is in use */
+
+	struct dm_buffer **pinned;	/* held buffers of the upper levels */
+	sector_t nr_pinned;	/* hash blocks from hash_start to pin */
+	spinlock_t prefetch_lock; /* protects the fields below */
+	unsigned long prefetch_clock; /* ios seen, orders the streams */
+	struct dm_verity_stream prefetch_streams[DM_VERITY_PREFETCH_STREAMS];
+
+	/* dm-bufio cache hits and misses per tree level */
+	atomic64_t level_hits[DM_VERITY_MAX_LEVELS];
+	atomic64_t level_misses[DM_VERITY_MAX_LEVELS];
+};
+
+/*
+ * A data block mapped and waiting to be hashed together with others by
+ * verity_verify_pending_blocks().
+ */
+struct dm_verity_pending_block {
+	struct page *page;
+	u8 *data;
+	sector_t block;
+	struct bvec_iter start;
+	u8 want_digest[DM_VERITY_MAX_DIGEST_SIZE];
+	u8 real_digest[DM_VERITY_MAX_DIGEST_SIZE];
 };
 
 struct dm_verity_io {
@@ -79,6 +120,9 @@ struct dm_verity_io {
 
 	struct work_struct work;
 
+	unsigned num_pending;
+	struct dm_verity_pending_block pending[DM_VERITY_MAX_PENDING_BLOCKS];
+
 	/*
 	 * Three variably-size fields follow this struct:
 	 *
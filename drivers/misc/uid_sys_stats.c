@@ -21,6 +21,7 @@
 #include <linux/kernel.h>
 #include <linux/list.h>
 #include <linux/mm.h>
+#include <linux/mutex.h>
 #include <linux/proc_fs.h>
 #include <linux/profile.h>
 #include <linux/rtmutex.h>
@@ -28,6 +29,8 @@
 #include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <uapi/linux/uid_stats.h>
 
 
 #define UID_HASH_BITS	10
@@ -73,6 +76,9 @@ struct uid_entry {
 	int state;
 	struct io_stats io[UID_STATE_SIZE];
 	struct hlist_node hash;
+	/* uid_stats_gen of the binary snapshot in which @last changed */
+	u64 gen;
+	struct uid_sys_stats_record last;
 #ifdef CONFIG_UID_SYS_STATS_DEBUG
 	DECLARE_HASHTABLE(task_entries, UID_HASH_BITS);
 #endif
@@ -329,7 +335,7 @@ static struct uid_entry *find_or_register_uid(uid_t uid)
 	return uid_entry;
 }
 
-static int uid_cputime_show(struct seq_file *m, void *v)
+static int update_cputime_all_locked(void)
 {
 	struct uid_entry *uid_entry = NULL;
 	struct task_struct *task, *temp;
@@ -339,8 +345,6 @@ static int uid_cputime_show(struct seq_file *m, void *v)
 	unsigned long bkt;
 	uid_t uid;
 
-	rt_mutex_lock(&uid_lock);
-
 	hash_for_each(hash_table, bkt, uid_entry, hash) {
 		uid_entry->active_stime = 0;
 		uid_entry->active_utime = 0;
@@ -353,7 +357,6 @@ static int uid_cputime_show(struct seq_file *m, void *v)
 			uid_entry = find_or_register_uid(uid);
 		if (!uid_entry) {
 			rcu_read_unlock();
-			rt_mutex_unlock(&uid_lock);
 			pr_err("%s: failed to find the uid_entry for uid %d\n",
 				__func__, uid);
 			return -ENOMEM;
@@ -364,16 +367,37 @@ static int uid_cputime_show(struct seq_file *m, void *v)
 	} while_each_thread(temp, task);
 	rcu_read_unlock();
 
+	return 0;
+}
+
+static inline u64 cputime_to_usecs_exported(cputime_t cputime)
+{
+	return (u64)jiffies_to_msecs(cputime_to_jiffies(cputime)) *
+		USEC_PER_MSEC;
+}
+
+static int uid_cputime_show(struct seq_file *m, void *v)
+{
+	struct uid_entry *uid_entry = NULL;
+	unsigned long bkt;
+	int ret;
+
+	rt_mutex_lock(&uid_lock);
+
+	ret = update_cputime_all_locked();
+	if (ret) {
+		rt_mutex_unlock(&uid_lock);
+		return ret;
+	}
+
 	hash_for_each(hash_table, bkt, uid_entry, hash) {
 		cputime_t total_utime = uid_entry->utime +
 							uid_entry->active_utime;
 		cputime_t total_stime = uid_entry->stime +
 							uid_entry->active_stime;
 		seq_printf(m, "%d: %llu %llu\n", uid_entry->uid,
-			(unsigned long long)jiffies_to_msecs(
-				cputime_to_jiffies(total_utime)) * USEC_PER_MSEC,
-			(unsigned long long)jiffies_to_msecs(
-				cputime_to_jiffies(total_stime)) * USEC_PER_MSEC);
+			cputime_to_usecs_exported(total_utime),
+			cputime_to_usecs_exported(total_stime));
 	}
 
 	rt_mutex_unlock(&uid_lock);
@@ -566,6 +590,158 @@ static const struct file_operations uid_io_fops = {
 	.release	= single_release,
 };
 
+/*
+ * Binary snapshots, see include/uapi/linux/uid_stats.h. uid_stats_gen is
+ * bumped with every snapshot and each uid_entry remembers the generation
+ * its exported stats last changed in, so that every open file can be
+ * handed only the UIDs that changed since its own previous snapshot.
+ */
+static u64 uid_stats_gen;
+
+struct uid_stats_bin {
+	struct mutex lock;
+	u64 last_gen;
+	void *buf;
+	size_t len;
+};
+
+static void fill_uid_sys_stats_record(struct uid_sys_stats_record *rec,
+				      struct uid_entry *uid_entry)
+{
+	int i;
+
+	BUILD_BUG_ON(UID_STATE_FOREGROUND != UID_IO_RECORD_FOREGROUND ||
+		     UID_STATE_BACKGROUND != UID_IO_RECORD_BACKGROUND ||
+		     UID_STATE_BUCKET_SIZE > UID_IO_RECORD_STATES);
+
+	memset(rec, 0, sizeof(*rec));
+	rec->uid = uid_entry->uid;
+	rec->utime_us = cputime_to_usecs_exported(uid_entry->utime +
+						  uid_entry->active_utime);
+	rec->stime_us = cputime_to_usecs_exported(uid_entry->stime +
+						  uid_entry->active_stime);
+
+	for (i = 0; i < UID_STATE_BUCKET_SIZE; i++) {
+		rec->io[i].rchar = uid_entry->io[i].rchar;
+		rec->io[i].wchar = uid_entry->io[i].wchar;
+		rec->io[i].read_bytes = uid_entry->io[i].read_bytes;
+		rec->io[i].write_bytes = uid_entry->io[i].write_bytes;
+		rec->io[i].fsync = uid_entry->io[i].fsync;
+	}
+}
+
+static int uid_sys_stats_bin_snapshot(struct uid_stats_bin *bin)
+{
+	struct uid_sys_stats_record *rec;
+	struct uid_stats_header *hdr;
+	struct uid_entry *uid_entry;
+	unsigned long bkt;
+	size_t nr = 0;
+	int ret;
+
+	rt_mutex_lock(&uid_lock);
+
+	ret = update_cputime_all_locked();
+	if (ret)
+		goto out;
+	update_io_stats_all_locked();
+
+	hash_for_each(hash_table, bkt, uid_entry, hash)
+		nr++;
+
+	vfree(bin->buf);
+	bin->len = 0;
+	bin->buf = vzalloc(sizeof(*hdr) + nr * sizeof(*rec));
+	if (!bin->buf) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	hdr = bin->buf;
+	rec = (struct uid_sys_stats_record *)(hdr + 1);
+	uid_stats_gen++;
+
+	hash_for_each(hash_table, bkt, uid_entry, hash) {
+		struct uid_sys_stats_record cur;
+
+		fill_uid_sys_stats_record(&cur, uid_entry);
+		if (memcmp(&cur, &uid_entry->last, sizeof(cur))) {
+			uid_entry->last = cur;
+			uid_entry->gen = uid_stats_gen;
+		}
+
+		if (uid_entry->gen <= bin->last_gen)
+			continue;
+
+		rec[hdr->nr_records++] = cur;
+	}
+
+	hdr->magic = UID_STATS_MAGIC;
+	hdr->version = UID_STATS_VERSION;
+	hdr->flags = bin->last_gen ? UID_STATS_DELTA : 0;
+	hdr->record_size = sizeof(*rec);
+	hdr->generation = uid_stats_gen;
+
+	bin->len = sizeof(*hdr) + hdr->nr_records * sizeof(*rec);
+	bin->last_gen = uid_stats_gen;
+
+out:
+	rt_mutex_unlock(&uid_lock);
+	return ret;
+}
+
+static int uid_sys_stats_bin_open(struct inode *inode, struct file *file)
+{
+	struct uid_stats_bin *bin;
+
+	bin = kzalloc(sizeof(*bin), GFP_KERNEL);
+	if (!bin)
+		return -ENOMEM;
+
+	mutex_init(&bin->lock);
+	file->private_data = bin;
+
+	return 0;
+}
+
+static ssize_t uid_sys_stats_bin_read(struct file *file, char __user *buf,
+				      size_t count, loff_t *ppos)
+{
+	struct uid_stats_bin *bin = file->private_data;
+	ssize_t ret;
+
+	mutex_lock(&bin->lock);
+
+	/* Every read from the start is a new snapshot */
+	if (*ppos == 0) {
+		ret = uid_sys_stats_bin_snapshot(bin);
+		if (ret)
+			goto out;
+	}
+
+	ret = simple_read_from_buffer(buf, count, ppos, bin->buf, bin->len);
+out:
+	mutex_unlock(&bin->lock);
+	return ret;
+}
+
+static int uid_sys_stats_bin_release(struct inode *inode, struct file *file)
+{
+	struct uid_stats_bin *bin = file->private_data;
+
+	vfree(bin->buf);
+	kfree(bin);
+
+	return 0;
+}
+
+static const struct file_operations uid_sys_stats_bin_fops = {
+	.open		= uid_sys_stats_bin_open,
+	.read		= uid_sys_stats_bin_read,
+	.llseek		= default_llseek,
+	.release	= uid_sys_stats_bin_release,
+};
+
 static int uid_procstat_open(struct inode *inode, struct file *file)
 {
 	return single_open(file, NULL, NULL);
@@ -692,6 +868,9 @@ static int __init proc_uid_sys_stats_init(void)
 	proc_create_data("set", 0222, proc_parent,
 		&uid_procstat_fops, NULL);
 
+	proc_create_data("uid_sys_stats_bin", 0444, NULL,
+		&uid_sys_stats_bin_fops, NULL);
+
 	profile_event_register(PROFILE_TASK_EXIT, &process_notifier_block);
 
 	return 0;
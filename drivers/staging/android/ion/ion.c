@@ -2070,6 +2070,9 @@ void ion_device_add_heap(struct ion_device *dev, struct ion_heap *heap)
 		}
 	}
 
+	if (heap->debugfs_init)
+		heap->debugfs_init(heap, dev->heaps_debug_root);
+
 	up_write(&dev->lock);
 }
 EXPORT_SYMBOL(ion_device_add_heap);
@@ -231,22 +231,28 @@ static int ion_heap_deferred_free(void *data)
 	struct ion_heap *heap = data;
 
 	while (true) {
-		struct ion_buffer *buffer;
+		struct ion_buffer *buffer, *tmp;
+		LIST_HEAD(batch);
 
 		wait_event_freezable(heap->waitqueue,
 				     ion_heap_freelist_size(heap) > 0);
 
+		/*
+		 * Take everything queued so far in one go: a teardown burst
+		 * is then destroyed back to back instead of bouncing the
+		 * free list against the threads still queueing buffers. The
+		 * batch is out of the shrinker's reach from here on, so its
+		 * size is dropped from the free list right away.
+		 */
 		spin_lock(&heap->free_lock);
-		if (list_empty(&heap->free_list)) {
-			spin_unlock(&heap->free_lock);
-			continue;
-		}
-		buffer = list_first_entry(&heap->free_list, struct ion_buffer,
-					  list);
-		list_del(&buffer->list);
-		heap->free_list_size -= buffer->size;
+		list_splice_init(&heap->free_list, &batch);
+		heap->free_list_size = 0;
 		spin_unlock(&heap->free_lock);
-		ion_buffer_destroy(buffer);
+
+		list_for_each_entry_safe(buffer, tmp, &batch, list) {
+			list_del(&buffer->list);
+			ion_buffer_destroy(buffer);
+		}
 	}
 
 	return 0;
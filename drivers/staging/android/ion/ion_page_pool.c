@@ -18,14 +18,25 @@
 #include <linux/debugfs.h>
 #include <linux/dma-mapping.h>
 #include <linux/err.h>
+#include <linux/freezer.h>
 #include <linux/fs.h>
+#include <linux/jiffies.h>
+#include <linux/kthread.h>
 #include <linux/list.h>
+#include <linux/mutex.h>
 #include <linux/init.h>
+#include <linux/percpu.h>
 #include <linux/slab.h>
 #include <linux/swap.h>
 #include <linux/vmalloc.h>
 #include "ion_priv.h"
 
+/* how long refill stays off after the shrinker or an allocation failure */
+#define ION_POOL_REFILL_BACKOFF		(HZ)
+
+/* pages a per-cpu free list holds before it is flushed into the pool */
+#define ION_POOL_PCP_PAGES		64
+
 static void *ion_page_pool_alloc_pages(struct ion_page_pool *pool)
 {
 	struct page *page;
@@ -55,9 +66,18 @@ static void ion_page_pool_free_pages(struct ion_page_pool *pool,
 	__free_pages(page, pool->order);
 }
 
-static int ion_page_pool_add(struct ion_page_pool *pool, struct page *page)
+static void ion_page_pool_account(struct ion_page_pool *pool,
+				  struct page *page, bool add)
+{
+	long bytes = 1L << (PAGE_SHIFT + pool->order);
+
+	mod_node_page_state(page_pgdat(page), NR_INDIRECTLY_RECLAIMABLE_BYTES,
+			    add ? bytes : -bytes);
+}
+
+/* Must be called with pool->mutex held, the page already accounted. */
+static void __ion_page_pool_add(struct ion_page_pool *pool, struct page *page)
 {
-	mutex_lock(&pool->mutex);
 	if (PageHighMem(page)) {
 		list_add_tail(&page->lru, &pool->high_items);
 		pool->high_count++;
@@ -65,13 +85,31 @@ static int ion_page_pool_add(struct ion_page_pool *pool, struct page *page)
 		list_add_tail(&page->lru, &pool->low_items);
 		pool->low_count++;
 	}
+}
 
-	mod_node_page_state(page_pgdat(page), NR_INDIRECTLY_RECLAIMABLE_BYTES,
-			    (1 << (PAGE_SHIFT + pool->order)));
+static int ion_page_pool_add(struct ion_page_pool *pool, struct page *page)
+{
+	ion_page_pool_account(pool, page, true);
+	mutex_lock(&pool->mutex);
+	__ion_page_pool_add(pool, page);
 	mutex_unlock(&pool->mutex);
 	return 0;
 }
 
+/* Moves a list of already accounted pages into the pool in one go. */
+static void ion_page_pool_add_list(struct ion_page_pool *pool,
+				   struct list_head *pages)
+{
+	struct page *page, *tmp;
+
+	mutex_lock(&pool->mutex);
+	list_for_each_entry_safe(page, tmp, pages, lru) {
+		list_del(&page->lru);
+		__ion_page_pool_add(pool, page);
+	}
+	mutex_unlock(&pool->mutex);
+}
+
 static struct page *ion_page_pool_remove(struct ion_page_pool *pool, bool high)
 {
 	struct page *page;
@@ -87,11 +125,164 @@ static struct page *ion_page_pool_remove(struct ion_page_pool *pool, bool high)
 	}
 
 	list_del(&page->lru);
-	mod_node_page_state(page_pgdat(page), NR_INDIRECTLY_RECLAIMABLE_BYTES,
-			    -(1 << (PAGE_SHIFT + pool->order)));
+	ion_page_pool_account(pool, page, false);
 	return page;
 }
 
+/*
+ * Frees land on a per-cpu list first and are flushed into the pool once
+ * pcp_batch of them have accumulated, so a burst of buffer teardown takes
+ * pool->mutex once per batch instead of once per page. Pools of large
+ * orders have no per-cpu lists (pcp_batch == 0).
+ */
+static void ion_page_pool_pcp_add(struct ion_page_pool *pool,
+				  struct page *page)
+{
+	struct ion_page_pool_pcp *pcp;
+	LIST_HEAD(batch);
+
+	ion_page_pool_account(pool, page, true);
+
+	pcp = get_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	list_add(&page->lru, &pcp->items);
+	if (++pcp->count >= pool->pcp_batch) {
+		list_splice_init(&pcp->items, &batch);
+		pcp->count = 0;
+	}
+	spin_unlock(&pcp->lock);
+	put_cpu_ptr(pool->pcp);
+
+	if (!list_empty(&batch))
+		ion_page_pool_add_list(pool, &batch);
+}
+
+static struct page *ion_page_pool_pcp_remove(struct ion_page_pool *pool)
+{
+	struct ion_page_pool_pcp *pcp;
+	struct page *page;
+
+	if (!pool->pcp_batch)
+		return NULL;
+
+	pcp = get_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	page = list_first_entry_or_null(&pcp->items, struct page, lru);
+	if (page) {
+		list_del(&page->lru);
+		pcp->count--;
+	}
+	spin_unlock(&pcp->lock);
+	put_cpu_ptr(pool->pcp);
+
+	if (page)
+		ion_page_pool_account(pool, page, false);
+	return page;
+}
+
+static int ion_page_pool_pcp_count(struct ion_page_pool *pool)
+{
+	int cpu, count = 0;
+
+	if (!pool->pcp_batch)
+		return 0;
+
+	for_each_possible_cpu(cpu)
+		count += READ_ONCE(per_cpu_ptr(pool->pcp, cpu)->count);
+
+	return count;
+}
+
+void ion_page_pool_drain(struct ion_page_pool *pool)
+{
+	struct ion_page_pool_pcp *pcp;
+	LIST_HEAD(pages);
+	int cpu;
+
+	if (!pool->pcp_batch)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(pool->pcp, cpu);
+		spin_lock(&pcp->lock);
+		list_splice_init(&pcp->items, &pages);
+		pcp->count = 0;
+		spin_unlock(&pcp->lock);
+	}
+
+	if (!list_empty(&pages))
+		ion_page_pool_add_list(pool, &pages);
+}
+
+static inline int ion_page_pool_count(struct ion_page_pool *pool)
+{
+	return pool->high_count + pool->low_count;
+}
+
+static bool ion_page_pool_refill_needed(struct ion_page_pool *pool)
+{
+	return ion_page_pool_count(pool) < pool->low_mark &&
+		time_after_eq(jiffies, READ_ONCE(pool->refill_resume));
+}
+
+static void ion_page_pool_refill_backoff(struct ion_page_pool *pool)
+{
+	WRITE_ONCE(pool->refill_resume, jiffies + ION_POOL_REFILL_BACKOFF);
+}
+
+/*
+ * Pages are taken from the buddy allocator without direct reclaim; if memory
+ * is tight the refill simply stops until the next wakeup after the backoff.
+ */
+static void ion_page_pool_refill(struct ion_page_pool *pool)
+{
+	gfp_t gfp_mask = (pool->gfp_mask | __GFP_NORETRY | __GFP_NOWARN) &
+			 ~(__GFP_DIRECT_RECLAIM | __GFP_ZERO);
+	u32 target = max(READ_ONCE(pool->low_mark), READ_ONCE(pool->high_mark));
+	struct page *page;
+
+	while (ion_page_pool_count(pool) < target &&
+	       time_after_eq(jiffies, READ_ONCE(pool->refill_resume)) &&
+	       !kthread_should_stop()) {
+		page = alloc_pages(gfp_mask, pool->order);
+		if (!page) {
+			ion_page_pool_refill_backoff(pool);
+			break;
+		}
+
+		if (msm_ion_heap_high_order_page_zero(pool->dev, page,
+						      pool->order)) {
+			__free_pages(page, pool->order);
+			ion_page_pool_refill_backoff(pool);
+			break;
+		}
+
+		ion_page_pool_alloc_set_cache_policy(pool, page);
+		ion_page_pool_add(pool, page);
+	}
+}
+
+static int ion_page_pool_refill_thread(void *data)
+{
+	struct ion_page_pool *pool = data;
+
+	set_freezable();
+	while (!kthread_should_stop()) {
+		wait_event_freezable(pool->refill_wait,
+				     ion_page_pool_refill_needed(pool) ||
+				     kthread_should_stop());
+		ion_page_pool_refill(pool);
+	}
+
+	return 0;
+}
+
+static void ion_page_pool_kick_refill(struct ion_page_pool *pool)
+{
+	if (pool->refill_task && ion_page_pool_refill_needed(pool))
+		wake_up(&pool->refill_wait);
+}
+
 void *ion_page_pool_alloc(struct ion_page_pool *pool, bool *from_pool)
 {
 	struct page *page = NULL;
@@ -100,16 +291,21 @@ void *ion_page_pool_alloc(struct ion_page_pool *pool, bool *from_pool)
 
 	*from_pool = true;
 
-	if (mutex_trylock(&pool->mutex)) {
+	page = ion_page_pool_pcp_remove(pool);
+	if (!page && mutex_trylock(&pool->mutex)) {
 		if (pool->high_count)
 			page = ion_page_pool_remove(pool, true);
 		else if (pool->low_count)
 			page = ion_page_pool_remove(pool, false);
 		mutex_unlock(&pool->mutex);
 	}
+	ion_page_pool_kick_refill(pool);
 	if (!page) {
+		atomic_inc(&pool->misses);
 		page = ion_page_pool_alloc_pages(pool);
 		*from_pool = false;
+	} else {
+		atomic_inc(&pool->hits);
 	}
 	return page;
 }
@@ -124,7 +320,8 @@ void *ion_page_pool_alloc_pool_only(struct ion_page_pool *pool)
 	if (!pool)
 		return NULL;
 
-	if (mutex_trylock(&pool->mutex)) {
+	page = ion_page_pool_pcp_remove(pool);
+	if (!page && mutex_trylock(&pool->mutex)) {
 		if (pool->high_count)
 			page = ion_page_pool_remove(pool, true);
 		else if (pool->low_count)
@@ -139,11 +336,26 @@ void ion_page_pool_free(struct ion_page_pool *pool, struct page *page)
 {
 	int ret;
 
+	if (pool->pcp_batch) {
+		ion_page_pool_pcp_add(pool, page);
+		return;
+	}
+
 	ret = ion_page_pool_add(pool, page);
 	if (ret)
 		ion_page_pool_free_pages(pool, page);
 }
 
+void ion_page_pool_free_list(struct ion_page_pool *pool,
+			     struct list_head *pages)
+{
+	struct page *page;
+
+	list_for_each_entry(page, pages, lru)
+		ion_page_pool_account(pool, page, true);
+	ion_page_pool_add_list(pool, pages);
+}
+
 void ion_page_pool_free_immediate(struct ion_page_pool *pool, struct page *page)
 {
 	ion_page_pool_free_pages(pool, page);
@@ -151,7 +363,7 @@ void ion_page_pool_free_immediate(struct ion_page_pool *pool, struct page *page)
 
 int ion_page_pool_total(struct ion_page_pool *pool, bool high)
 {
-	int count = pool->low_count;
+	int count = pool->low_count + ion_page_pool_pcp_count(pool);
 
 	if (high)
 		count += pool->high_count;
@@ -173,6 +385,10 @@ int ion_page_pool_shrink(struct ion_page_pool *pool, gfp_t gfp_mask,
 	if (nr_to_scan == 0)
 		return ion_page_pool_total(pool, high);
 
+	/* don't refill what reclaim is asking us to give back */
+	ion_page_pool_refill_backoff(pool);
+	ion_page_pool_drain(pool);
+
 	while (freed < nr_to_scan) {
 		struct page *page;
 
@@ -197,9 +413,29 @@ struct ion_page_pool *ion_page_pool_create(struct device *dev, gfp_t gfp_mask,
 					   unsigned int order)
 {
 	struct ion_page_pool *pool = kmalloc(sizeof(*pool), GFP_KERNEL);
+	int cpu;
 
 	if (!pool)
 		return NULL;
+
+	pool->pcp_batch = ION_POOL_PCP_PAGES >> order;
+	if (pool->pcp_batch) {
+		pool->pcp = alloc_percpu(struct ion_page_pool_pcp);
+		if (!pool->pcp) {
+			kfree(pool);
+			return NULL;
+		}
+		for_each_possible_cpu(cpu) {
+			struct ion_page_pool_pcp *pcp = per_cpu_ptr(pool->pcp,
+								    cpu);
+
+			spin_lock_init(&pcp->lock);
+			INIT_LIST_HEAD(&pcp->items);
+			pcp->count = 0;
+		}
+	} else {
+		pool->pcp = NULL;
+	}
 	pool->dev = dev;
 	pool->high_count = 0;
 	pool->low_count = 0;
@@ -209,12 +445,65 @@ struct ion_page_pool *ion_page_pool_create(struct device *dev, gfp_t gfp_mask,
 	pool->order = order;
 	mutex_init(&pool->mutex);
 	plist_node_init(&pool->list, order);
+	pool->low_mark = 0;
+	pool->high_mark = 0;
+	atomic_set(&pool->hits, 0);
+	atomic_set(&pool->misses, 0);
+	pool->refill_resume = jiffies;
+	init_waitqueue_head(&pool->refill_wait);
+	pool->refill_name = NULL;
+	pool->refill_task = NULL;
 
 	return pool;
 }
 
+/* serializes starting refill threads against watermark updates */
+static DEFINE_MUTEX(ion_page_pool_refill_lock);
+
+int ion_page_pool_set_marks(struct ion_page_pool *pool, u32 low_mark,
+			    u32 high_mark)
+{
+	struct task_struct *task;
+	int ret = 0;
+
+	mutex_lock(&ion_page_pool_refill_lock);
+	WRITE_ONCE(pool->low_mark, low_mark);
+	WRITE_ONCE(pool->high_mark, max(low_mark, high_mark));
+
+	/* pools without watermarks get their thread once they are given some */
+	if (pool->refill_name && !pool->refill_task && pool->high_mark) {
+		task = kthread_run(ion_page_pool_refill_thread, pool,
+				   "ion_pool_%s_%u", pool->refill_name,
+				   pool->order);
+		if (IS_ERR(task)) {
+			pr_err("%s: creating refill thread for %s pool failed\n",
+			       __func__, pool->refill_name);
+			ret = PTR_ERR(task);
+			goto out;
+		}
+		pool->refill_task = task;
+	}
+
+	/* fill the pool up to the new marks rather than on an allocation */
+	if (pool->refill_task)
+		wake_up(&pool->refill_wait);
+out:
+	mutex_unlock(&ion_page_pool_refill_lock);
+	return ret;
+}
+
+int ion_page_pool_start_refill(struct ion_page_pool *pool, const char *name,
+			       u32 low_mark, u32 high_mark)
+{
+	pool->refill_name = name;
+	return ion_page_pool_set_marks(pool, low_mark, high_mark);
+}
+
 void ion_page_pool_destroy(struct ion_page_pool *pool)
 {
+	if (pool->refill_task)
+		kthread_stop(pool->refill_task);
+	free_percpu(pool->pcp);
 	kfree(pool);
 }
 
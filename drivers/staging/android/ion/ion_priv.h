@@ -194,6 +194,8 @@ struct ion_heap_ops {
  * @task:		task struct of deferred free thread
  * @debug_show:		called when heap debug file is read to add any
  *			heap specific debug info to output
+ * @debugfs_init:	called when the heap is added to the device to create
+ *			heap specific debugfs entries under @parent
  *
  * Represents a pool of memory from which buffers can be made.  In some
  * systems the only heap is regular system memory allocated via vmalloc.
@@ -217,6 +219,7 @@ struct ion_heap {
 	struct task_struct *task;
 
 	int (*debug_show)(struct ion_heap *heap, struct seq_file *, void *);
+	void (*debugfs_init)(struct ion_heap *heap, struct dentry *parent);
 	atomic_long_t total_allocated;
 	atomic_long_t total_handles;
 };
@@ -448,6 +451,18 @@ void ion_carveout_free(struct ion_heap *heap, ion_phys_addr_t addr,
  * many systems
  */
 
+/**
+ * struct ion_page_pool_pcp - per-cpu free list in front of a page pool
+ * @lock:		protects the list against draining from other cpus
+ * @count:		number of items on the list
+ * @items:		pages freed on this cpu and not yet flushed to the pool
+ */
+struct ion_page_pool_pcp {
+	spinlock_t lock;
+	int count;
+	struct list_head items;
+};
+
 /**
  * struct ion_page_pool - pagepool struct
  * @high_count:		number of highmem items in the pool
@@ -459,11 +474,26 @@ void ion_carveout_free(struct ion_heap *heap, ion_phys_addr_t addr,
  * @gfp_mask:		gfp_mask to use from alloc
  * @order:		order of pages in the pool
  * @list:		plist node for list of pools
+ * @low_mark:		refill is started when the pool holds fewer items
+ * @high_mark:		refill stops once the pool holds this many items
+ * @hits:		allocations served from the pool
+ * @misses:		allocations that fell back to the page allocator
+ * @refill_resume:	jiffies before which the pool must not be refilled
+ * @refill_wait:	wait queue the refill thread sleeps on
+ * @refill_name:	name for the refill thread, NULL if refill is disabled
+ * @refill_task:	background refill thread, NULL until the pool has marks
+ * @pcp_batch:		items a per-cpu list holds before it is flushed,
+ *			0 if the pool has no per-cpu lists
+ * @pcp:		per-cpu free lists
  *
  * Allows you to keep a pool of pre allocated pages to use from your heap.
  * Keeping a pool of pages that is ready for dma, ie any cached mapping have
  * been invalidated from the cache, provides a significant performance benefit
  * on many systems
+ *
+ * The watermarks are counted in items of 2^order pages. Pages added by the
+ * refill thread are zeroed and flushed before they reach the pool, so they
+ * are interchangeable with pages returned by ion_page_pool_free().
  */
 struct ion_page_pool {
 	int high_count;
@@ -475,6 +505,16 @@ struct ion_page_pool {
 	gfp_t gfp_mask;
 	unsigned int order;
 	struct plist_node list;
+	u32 low_mark;
+	u32 high_mark;
+	atomic_t hits;
+	atomic_t misses;
+	unsigned long refill_resume;
+	wait_queue_head_t refill_wait;
+	const char *refill_name;
+	struct task_struct *refill_task;
+	int pcp_batch;
+	struct ion_page_pool_pcp __percpu *pcp;
 };
 
 struct ion_page_pool *ion_page_pool_create(struct device *dev, gfp_t gfp_mask,
@@ -484,7 +524,36 @@ void *ion_page_pool_alloc(struct ion_page_pool *a, bool *from_pool);
 void *ion_page_pool_alloc_pool_only(struct ion_page_pool *a);
 void ion_page_pool_free(struct ion_page_pool *a, struct page *b);
 void ion_page_pool_free_immediate(struct ion_page_pool *, struct page *);
+void ion_page_pool_free_list(struct ion_page_pool *pool,
+			     struct list_head *pages);
+void ion_page_pool_drain(struct ion_page_pool *pool);
 int ion_page_pool_total(struct ion_page_pool *pool, bool high);
+
+/**
+ * ion_page_pool_start_refill - enable background refill of a pool
+ * @pool:		the pool
+ * @name:		name of the pool, used to name the thread
+ * @low_mark:		initial low watermark in items
+ * @high_mark:		initial high watermark in items
+ *
+ * The refill thread is only started once the pool has a non-zero watermark.
+ * It keeps between @low_mark and @high_mark zeroed items in the pool
+ * and backs off for a while whenever the shrinker takes pages from it.
+ */
+int ion_page_pool_start_refill(struct ion_page_pool *pool, const char *name,
+			       u32 low_mark, u32 high_mark);
+
+/**
+ * ion_page_pool_set_marks - change the refill watermarks of a pool
+ * @pool:		the pool
+ * @low_mark:		new low watermark in items
+ * @high_mark:		new high watermark in items
+ *
+ * Starts the refill thread if refill is enabled and the pool had none yet,
+ * and wakes it so the pool is topped up to the new marks.
+ */
+int ion_page_pool_set_marks(struct ion_page_pool *pool, u32 low_mark,
+			    u32 high_mark);
 size_t ion_system_heap_secure_page_pool_total(struct ion_heap *heap, int vmid);
 
 #ifdef CONFIG_ION_POOL_CACHE_POLICY
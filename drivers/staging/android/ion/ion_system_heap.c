@@ -16,6 +16,7 @@
  */
 
 #include <asm/page.h>
+#include <linux/debugfs.h>
 #include <linux/dma-mapping.h>
 #include <linux/err.h>
 #include <linux/highmem.h>
@@ -144,6 +145,20 @@ static struct page *alloc_buffer_page(struct ion_system_heap *heap,
 	return page;
 }
 
+static struct ion_page_pool *buffer_page_pool(struct ion_system_heap *heap,
+					      struct ion_buffer *buffer,
+					      int index)
+{
+	int vmid = get_secure_vmid(buffer->flags);
+
+	if (vmid > 0)
+		return heap->secure_pools[vmid][index];
+	else if (ion_buffer_cached(buffer))
+		return heap->cached_pools[index];
+	else
+		return heap->uncached_pools[index];
+}
+
 /*
  * For secure pages that need to be freed and not added back to the pool; the
  *  hyp_unassign should be called before calling this function
@@ -152,18 +167,10 @@ static void free_buffer_page(struct ion_system_heap *heap,
 			     struct ion_buffer *buffer, struct page *page,
 			     unsigned int order)
 {
-	bool cached = ion_buffer_cached(buffer);
-	int vmid = get_secure_vmid(buffer->flags);
-
 	if (!(buffer->flags & ION_FLAG_POOL_FORCE_ALLOC)) {
 		struct ion_page_pool *pool;
 
-		if (vmid > 0)
-			pool = heap->secure_pools[vmid][order_to_index(order)];
-		else if (cached)
-			pool = heap->cached_pools[order_to_index(order)];
-		else
-			pool = heap->uncached_pools[order_to_index(order)];
+		pool = buffer_page_pool(heap, buffer, order_to_index(order));
 
 		if (buffer->private_flags & ION_PRIV_FLAG_SHRINKER_FREE)
 			ion_page_pool_free_immediate(pool, page);
@@ -521,7 +528,7 @@ void ion_system_heap_free(struct ion_buffer *buffer)
 							heap);
 	struct sg_table *table = buffer->priv_virt;
 	struct scatterlist *sg;
-	LIST_HEAD(pages);
+	struct list_head pages[ARRAY_SIZE(orders)];
 	int i;
 	int vmid = get_secure_vmid(buffer->flags);
 	struct device *dev = heap->priv;
@@ -530,14 +537,33 @@ void ion_system_heap_free(struct ion_buffer *buffer)
 	    !(buffer->flags & ION_FLAG_POOL_FORCE_ALLOC)) {
 		if (vmid < 0)
 			msm_ion_heap_sg_table_zero(dev, table, buffer->size);
-	} else if (vmid > 0) {
-		if (ion_system_secure_heap_unassign_sg(table, vmid))
+	} else {
+		if (vmid > 0 && ion_system_secure_heap_unassign_sg(table, vmid))
 			return;
+
+		for_each_sg(table->sgl, sg, table->nents, i)
+			free_buffer_page(sys_heap, buffer, sg_page(sg),
+					 get_order(sg->length));
+		goto out;
 	}
 
+	/*
+	 * Sort the pages by order and hand each order back to its pool in a
+	 * single batch rather than taking the pool lock for every entry.
+	 */
+	for (i = 0; i < num_orders; i++)
+		INIT_LIST_HEAD(&pages[i]);
+
 	for_each_sg(table->sgl, sg, table->nents, i)
-		free_buffer_page(sys_heap, buffer, sg_page(sg),
-				 get_order(sg->length));
+		list_add_tail(&sg_page(sg)->lru,
+			      &pages[order_to_index(get_order(sg->length))]);
+
+	for (i = 0; i < num_orders; i++)
+		if (!list_empty(&pages[i]))
+			ion_page_pool_free_list(
+				buffer_page_pool(sys_heap, buffer, i),
+				&pages[i]);
+out:
 	sg_free_table(table);
 	kfree(table);
 }
@@ -568,6 +594,7 @@ static int ion_secure_page_pool_shrink(
 	if (nr_to_scan == 0)
 		return ion_page_pool_total(pool, true);
 
+	ion_page_pool_drain(pool);
 	while (freed < nr_to_scan) {
 		page = ion_page_pool_alloc_pool_only(pool);
 		if (!page)
@@ -668,6 +695,16 @@ static struct ion_heap_ops system_heap_ops = {
 	.shrink = ion_system_heap_shrink,
 };
 
+static void ion_system_heap_pool_show(struct seq_file *s,
+				      struct ion_page_pool *pool,
+				      const char *name)
+{
+	seq_printf(s,
+		   "order %u %s pool: low_mark %u high_mark %u hits %d misses %d\n",
+		   pool->order, name, pool->low_mark, pool->high_mark,
+		   atomic_read(&pool->hits), atomic_read(&pool->misses));
+}
+
 static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 				      void *unused)
 {
@@ -756,6 +793,13 @@ static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 		seq_printf(s, "pool total (uncached + cached + secure) = %lu\n",
 			   uncached_total + cached_total + secure_total);
 		seq_puts(s, "--------------------------------------------\n");
+		for (i = 0; i < num_orders; i++) {
+			ion_system_heap_pool_show(s, sys_heap->uncached_pools[i],
+						  "uncached");
+			ion_system_heap_pool_show(s, sys_heap->cached_pools[i],
+						  "cached");
+		}
+		seq_puts(s, "--------------------------------------------\n");
 	} else {
 		pr_info("-------------------------------------------------\n");
 		pr_info("uncached pool = %lu cached pool = %lu secure pool = %lu\n",
@@ -768,6 +812,126 @@ static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 	return 0;
 }
 
+static int ion_pool_low_mark_get(void *data, u64 *val)
+{
+	struct ion_page_pool *pool = data;
+
+	*val = READ_ONCE(pool->low_mark);
+	return 0;
+}
+
+static int ion_pool_low_mark_set(void *data, u64 val)
+{
+	struct ion_page_pool *pool = data;
+
+	if (val > U32_MAX)
+		return -EINVAL;
+	return ion_page_pool_set_marks(pool, val, READ_ONCE(pool->high_mark));
+}
+DEFINE_SIMPLE_ATTRIBUTE(ion_pool_low_mark_fops, ion_pool_low_mark_get,
+			ion_pool_low_mark_set, "%llu\n");
+
+static int ion_pool_high_mark_get(void *data, u64 *val)
+{
+	struct ion_page_pool *pool = data;
+
+	*val = READ_ONCE(pool->high_mark);
+	return 0;
+}
+
+static int ion_pool_high_mark_set(void *data, u64 val)
+{
+	struct ion_page_pool *pool = data;
+
+	if (val > U32_MAX)
+		return -EINVAL;
+	return ion_page_pool_set_marks(pool, READ_ONCE(pool->low_mark), val);
+}
+DEFINE_SIMPLE_ATTRIBUTE(ion_pool_high_mark_fops, ion_pool_high_mark_get,
+			ion_pool_high_mark_set, "%llu\n");
+
+static void ion_system_heap_pool_debugfs(struct dentry *dir,
+					 struct ion_page_pool *pool,
+					 const char *name)
+{
+	char buf[48];
+
+	snprintf(buf, sizeof(buf), "%s_%u_low_mark", name, pool->order);
+	debugfs_create_file(buf, 0644, dir, pool, &ion_pool_low_mark_fops);
+	snprintf(buf, sizeof(buf), "%s_%u_high_mark", name, pool->order);
+	debugfs_create_file(buf, 0644, dir, pool, &ion_pool_high_mark_fops);
+	snprintf(buf, sizeof(buf), "%s_%u_hits", name, pool->order);
+	debugfs_create_atomic_t(buf, 0444, dir, &pool->hits);
+	snprintf(buf, sizeof(buf), "%s_%u_misses", name, pool->order);
+	debugfs_create_atomic_t(buf, 0444, dir, &pool->misses);
+}
+
+static void ion_system_heap_debugfs_init(struct ion_heap *heap,
+					 struct dentry *parent)
+{
+	struct ion_system_heap *sys_heap = container_of(
+					heap, struct ion_system_heap, heap);
+	struct dentry *dir;
+	char name[64];
+	int i;
+
+	snprintf(name, sizeof(name), "%s_pools", heap->name);
+	dir = debugfs_create_dir(name, parent);
+	if (IS_ERR_OR_NULL(dir)) {
+		pr_err("Failed to create heap pool debugfs %s\n", name);
+		return;
+	}
+
+	for (i = 0; i < num_orders; i++) {
+		ion_system_heap_pool_debugfs(dir, sys_heap->uncached_pools[i],
+					     "uncached");
+		ion_system_heap_pool_debugfs(dir, sys_heap->cached_pools[i],
+					     "cached");
+	}
+}
+
+#ifdef CONFIG_ION_POOL_AUTO_REFILL
+/*
+ * Default watermarks, in items of the pool order. Only the uncached pools,
+ * which back camera and display buffers, are kept warm by default; the
+ * other pools get a refill thread once their marks are raised in debugfs.
+ */
+static void ion_system_heap_refill_marks(unsigned int order, bool cached,
+					 u32 *low_mark, u32 *high_mark)
+{
+	*low_mark = 0;
+	*high_mark = 0;
+	if (cached)
+		return;
+
+	if (order >= 8) {
+		*low_mark = 4;
+		*high_mark = 8;
+	} else if (order) {
+		*low_mark = 16;
+		*high_mark = 64;
+	}
+}
+
+static void ion_system_heap_start_refill(struct ion_page_pool **pools,
+					 bool cached)
+{
+	u32 low_mark, high_mark;
+	int i;
+
+	for (i = 0; i < num_orders; i++) {
+		ion_system_heap_refill_marks(orders[i], cached, &low_mark,
+					     &high_mark);
+		ion_page_pool_start_refill(pools[i],
+					   cached ? "cached" : "uncached",
+					   low_mark, high_mark);
+	}
+}
+#else
+static inline void ion_system_heap_start_refill(struct ion_page_pool **pools,
+						bool cached) { }
+#endif
+
 static void ion_system_heap_destroy_pools(struct ion_page_pool **pools)
 {
 	int i;
@@ -847,7 +1011,11 @@ struct ion_heap *ion_system_heap_create(struct ion_platform_heap *data)
 
 	mutex_init(&heap->split_page_mutex);
 
+	ion_system_heap_start_refill(heap->uncached_pools, false);
+	ion_system_heap_start_refill(heap->cached_pools, true);
+
 	heap->heap.debug_show = ion_system_heap_debug_show;
+	heap->heap.debugfs_init = ion_system_heap_debugfs_init;
 	return &heap->heap;
 
 err_create_cached_pools:
@@ -49,6 +49,8 @@
 #include <linux/cpuset.h>
 #include <linux/vmpressure.h>
 #include <linux/freezer.h>
+#include <linux/ktime.h>
+#include <linux/rbtree.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/almk.h>
@@ -116,11 +118,12 @@ struct lmk_event {
 	short oom_score_adj;
 	short min_score_adj;
 	unsigned long long start_time;
+	unsigned long scan_time_us;
 	struct list_head list;
 };
 
 void handle_lmk_event(struct task_struct *selected, int selected_tasksize,
-		      short min_score_adj)
+		      short min_score_adj, unsigned long scan_time_us)
 {
 	int head;
 	int tail;
@@ -155,6 +158,7 @@ void handle_lmk_event(struct task_struct *selected, int selected_tasksize,
 	event->start_time = nsec_to_clock_t(selected->real_start_time);
 	event->rss_in_pages = selected_tasksize;
 	event->min_score_adj = min_score_adj;
+	event->scan_time_us = scan_time_us;
 
 	event_buffer.head = (head + 1) & (MAX_BUFFERED_EVENTS - 1);
 
@@ -182,11 +186,12 @@ static int lmk_event_show(struct seq_file *s, void *unused)
 
 	event = &events[tail];
 
-	seq_printf(s, "%lu %lu %lu %lu %lu %lu %hd %hd %llu\n%s\n",
+	seq_printf(s, "%lu %lu %lu %lu %lu %lu %hd %hd %llu %lu\n%s\n",
 		(unsigned long) event->pid, (unsigned long) event->uid,
 		(unsigned long) event->group_leader_pid, event->min_flt,
 		event->maj_flt, event->rss_in_pages, event->oom_score_adj,
-		event->min_score_adj, event->start_time, event->taskname);
+		event->min_score_adj, event->start_time, event->scan_time_us,
+		event->taskname);
 
 	event_buffer.tail = (tail + 1) & (MAX_BUFFERED_EVENTS - 1);
 
@@ -400,6 +405,246 @@ static int test_task_lmk_waiting(struct task_struct *p)
 
 static DEFINE_MUTEX(scan_mutex);
 
+#ifdef CONFIG_ANDROID_LMK_ADJ_INDEX
+/*
+ * Thread group leaders sorted by oom_score_adj, highest first. Each task is
+ * keyed by the adj it had when it was last (re)inserted, cached in
+ * task->lmk_adj, so the order stays consistent while an adj write is in
+ * flight. lowmem_scan() walks it from the top and stops at the first task
+ * that can no longer be selected.
+ *
+ * Lock ordering: tasklist_lock -> lmk_adj_lock -> task_lock. The lock is
+ * taken from fork and exit with interrupts off, so lowmem_scan() only holds
+ * it to copy out a batch of candidates and inspects them after dropping it.
+ * It must not be held while signalling a task, since fork holds siglock
+ * when it adds the child.
+ */
+static struct rb_root lmk_adj_root = RB_ROOT;
+static DEFINE_SPINLOCK(lmk_adj_lock);
+
+/* killed leaders that are still in the index, under lmk_adj_lock */
+static int lmk_pending_victims;
+
+#define LMK_SCAN_BATCH	16
+
+struct lmk_candidates {
+	struct task_struct *tasks[LMK_SCAN_BATCH];
+	short adj[LMK_SCAN_BATCH];
+	int nr;
+	int pos;
+	bool more;
+};
+
+static void __lowmem_adj_index_add(struct task_struct *p)
+{
+	struct rb_node **link = &lmk_adj_root.rb_node;
+	struct rb_node *parent = NULL;
+	short adj = p->signal->oom_score_adj;
+
+	while (*link) {
+		struct task_struct *t;
+
+		parent = *link;
+		t = rb_entry(parent, struct task_struct, lmk_adj_node);
+		if (adj > t->lmk_adj)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+
+	p->lmk_adj = adj;
+	rb_link_node(&p->lmk_adj_node, parent, link);
+	rb_insert_color(&p->lmk_adj_node, &lmk_adj_root);
+}
+
+static void __lowmem_adj_index_del(struct task_struct *p)
+{
+	if (RB_EMPTY_NODE(&p->lmk_adj_node))
+		return;
+
+	rb_erase(&p->lmk_adj_node, &lmk_adj_root);
+	RB_CLEAR_NODE(&p->lmk_adj_node);
+}
+
+/* first task whose adj is at most @adj */
+static struct rb_node *__lowmem_adj_index_lookup(short adj)
+{
+	struct rb_node *node = lmk_adj_root.rb_node;
+	struct rb_node *found = NULL;
+
+	while (node) {
+		struct task_struct *t;
+
+		t = rb_entry(node, struct task_struct, lmk_adj_node);
+		if (t->lmk_adj <= adj) {
+			found = node;
+			node = node->rb_left;
+		} else {
+			node = node->rb_right;
+		}
+	}
+
+	return found;
+}
+
+void lowmem_adj_index_add(struct task_struct *p)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&lmk_adj_lock, flags);
+	__lowmem_adj_index_add(p);
+	spin_unlock_irqrestore(&lmk_adj_lock, flags);
+}
+
+void lowmem_adj_index_del(struct task_struct *p)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&lmk_adj_lock, flags);
+	if (p->lmk_victim) {
+		p->lmk_victim = false;
+		lmk_pending_victims--;
+	}
+	__lowmem_adj_index_del(p);
+	spin_unlock_irqrestore(&lmk_adj_lock, flags);
+}
+
+void lowmem_adj_index_update(struct task_struct *p)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&lmk_adj_lock, flags);
+	p = p->group_leader;
+	if (!RB_EMPTY_NODE(&p->lmk_adj_node) &&
+	    p->lmk_adj != p->signal->oom_score_adj) {
+		__lowmem_adj_index_del(p);
+		__lowmem_adj_index_add(p);
+	}
+	spin_unlock_irqrestore(&lmk_adj_lock, flags);
+}
+
+/*
+ * The scan stops before it reaches a task with a lower adj than the best
+ * candidate, so it can no longer see a victim of an earlier kill that is
+ * still dying further down. Count killed leaders until they leave the
+ * index instead; lowmem_deathpending_timeout still bounds the wait.
+ */
+static void lowmem_adj_index_mark_victim(struct task_struct *p)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&lmk_adj_lock, flags);
+	p = p->group_leader;
+	if (!RB_EMPTY_NODE(&p->lmk_adj_node) && !p->lmk_victim) {
+		p->lmk_victim = true;
+		lmk_pending_victims++;
+	}
+	spin_unlock_irqrestore(&lmk_adj_lock, flags);
+}
+
+static inline bool lowmem_adj_index_victim_pending(void)
+{
+	return READ_ONCE(lmk_pending_victims) > 0;
+}
+
+/*
+ * Copy the next batch of tasks with an adj of at least @floor. Tasks stay
+ * valid under the RCU read lock held by lowmem_scan() after they leave the
+ * index. If the last task of the previous batch was removed or moved in
+ * the meantime, resume after its old adj; tasks that change adj during the
+ * scan may then be seen twice or not at all, as with the full walk.
+ */
+static void lowmem_candidates_fill(struct lmk_candidates *c, short floor)
+{
+	struct task_struct *last = c->nr ? c->tasks[c->nr - 1] : NULL;
+	short last_adj = c->nr ? c->adj[c->nr - 1] : 0;
+	struct rb_node *node;
+
+	spin_lock_irq(&lmk_adj_lock);
+	if (!last)
+		node = rb_first(&lmk_adj_root);
+	else if (!RB_EMPTY_NODE(&last->lmk_adj_node) &&
+		 last->lmk_adj == last_adj)
+		node = rb_next(&last->lmk_adj_node);
+	else
+		node = __lowmem_adj_index_lookup(last_adj);
+
+	c->nr = 0;
+	c->pos = 0;
+	for (; node && c->nr < LMK_SCAN_BATCH; node = rb_next(node)) {
+		struct task_struct *t;
+
+		t = rb_entry(node, struct task_struct, lmk_adj_node);
+		if (t->lmk_adj < floor)
+			break;
+		c->tasks[c->nr] = t;
+		c->adj[c->nr] = t->lmk_adj;
+		c->nr++;
+	}
+	c->more = node && c->nr == LMK_SCAN_BATCH;
+	spin_unlock_irq(&lmk_adj_lock);
+}
+
+/* returns NULL once the remaining tasks have a lower adj than @floor */
+static struct task_struct *lowmem_candidates_next(struct lmk_candidates *c,
+						  short floor)
+{
+	if (++c->pos >= c->nr) {
+		if (!c->more)
+			return NULL;
+		lowmem_candidates_fill(c, floor);
+		if (!c->nr)
+			return NULL;
+	}
+
+	if (c->adj[c->pos] < floor)
+		return NULL;
+	return c->tasks[c->pos];
+}
+
+static struct task_struct *lowmem_candidates_first(struct lmk_candidates *c,
+						   short floor)
+{
+	c->nr = 0;
+	c->pos = -1;
+	c->more = true;
+	return lowmem_candidates_next(c, floor);
+}
+#else
+struct lmk_candidates {
+	struct task_struct *tsk;
+};
+
+static inline void lowmem_adj_index_mark_victim(struct task_struct *p) { }
+
+static inline bool lowmem_adj_index_victim_pending(void)
+{
+	return false;
+}
+
+static struct task_struct *lowmem_candidates_next(struct lmk_candidates *c,
+						  short floor)
+{
+	c->tsk = next_task(c->tsk);
+	return c->tsk != &init_task ? c->tsk : NULL;
+}
+
+static struct task_struct *lowmem_candidates_first(struct lmk_candidates *c,
+						   short floor)
+{
+	c->tsk = &init_task;
+	return lowmem_candidates_next(c, floor);
+}
+#endif
+
+/*
+ * Walk the tasks that could still be selected. @floor is re-read on every
+ * step, so the index walk stops as soon as a better candidate is found.
+ */
+#define for_each_lmk_candidate(tsk, c, floor)				\
+	for (tsk = lowmem_candidates_first(c, floor); tsk;		\
+	     tsk = lowmem_candidates_next(c, floor))
+
 static int can_use_cma_pages(gfp_t gfp_mask)
 {
 	int can_use = 0;
@@ -597,6 +842,9 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 	int array_size = ARRAY_SIZE(lowmem_adj);
 	int other_free;
 	int other_file;
+	ktime_t scan_start;
+	unsigned long scan_time_us;
+	struct lmk_candidates candidates;
 
 	if (!mutex_trylock(&scan_mutex))
 		return 0;
@@ -641,10 +889,17 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 		return 0;
 	}
 
+	if (lowmem_adj_index_victim_pending() &&
+	    time_before_eq(jiffies, lowmem_deathpending_timeout)) {
+		mutex_unlock(&scan_mutex);
+		return 0;
+	}
+
 	selected_oom_score_adj = min_score_adj;
 
+	scan_start = ktime_get();
 	rcu_read_lock();
-	for_each_process(tsk) {
+	for_each_lmk_candidate(tsk, &candidates, selected_oom_score_adj) {
 		struct task_struct *p;
 		short oom_score_adj;
 
@@ -708,6 +963,8 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 		lowmem_print(3, "select '%s' (%d), adj %hd, size %d, to kill\n",
 			     p->comm, p->pid, oom_score_adj, tasksize);
 	}
+	scan_time_us = ktime_us_delta(ktime_get(), scan_start);
+
 	if (selected) {
 		long cache_size = other_file * (long)(PAGE_SIZE / 1024);
 		long cache_limit = minfree * (long)(PAGE_SIZE / 1024);
@@ -735,6 +992,7 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 			}
 		}
 		task_unlock(selected);
+		lowmem_adj_index_mark_victim(selected);
 		trace_lowmemory_kill(selected, cache_size, cache_limit, free);
 		lowmem_print(1, "Killing '%s' (%d) (tgid %d), adj %hd,\n"
 			"to free %ldkB on behalf of '%s' (%d) because\n"
@@ -788,7 +1046,8 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 	mutex_unlock(&scan_mutex);
 
 	if (selected) {
-		handle_lmk_event(selected, selected_tasksize, min_score_adj);
+		handle_lmk_event(selected, selected_tasksize, min_score_adj,
+				 scan_time_us);
 		put_task_struct(selected);
 	}
 
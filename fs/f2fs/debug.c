@@ -24,6 +24,31 @@ static LIST_HEAD(f2fs_stat_list);
 static struct dentry *f2fs_debugfs_root;
 static DEFINE_MUTEX(f2fs_stat_mutex);
 
+static void update_victim_index_status(struct f2fs_sb_info *sbi)
+{
+	struct f2fs_stat_info *si = F2FS_STAT(sbi);
+	struct victim_index *vi = &DIRTY_I(sbi)->victim_index;
+	unsigned long long now = get_mtime(sbi, false);
+	struct victim_entry *ve;
+	unsigned int segno;
+	int i;
+
+	spin_lock(&vi->lock);
+	for (i = 0; i < NR_VICTIM_BUCKETS; i++) {
+		si->victim_secs[i] = vi->nr_secs[i];
+		si->victim_age[i] = 0;
+		if (list_empty(&vi->buckets[i]))
+			continue;
+
+		ve = list_first_entry(&vi->buckets[i], struct victim_entry,
+									list);
+		segno = GET_SEG_FROM_SEC(sbi, ve - vi->entries);
+		si->victim_age[i] = now - min(now,
+					get_section_mtime(sbi, segno));
+	}
+	spin_unlock(&vi->lock);
+}
+
 static void update_general_status(struct f2fs_sb_info *sbi)
 {
 	struct f2fs_stat_info *si = F2FS_STAT(sbi);
@@ -117,6 +142,11 @@ static void update_general_status(struct f2fs_sb_info *sbi)
 	si->bg_gc = sbi->bg_gc;
 	si->io_skip_bggc = sbi->io_skip_bggc;
 	si->other_skip_bggc = sbi->other_skip_bggc;
+	si->victim_search = sbi->victim_search;
+	si->victim_scanned = sbi->victim_scanned;
+	si->victim_search_ns = sbi->victim_search_ns;
+	si->gc_time_ns = sbi->gc_time_ns;
+	update_victim_index_status(sbi);
 	si->skipped_atomic_files[BG_GC] = sbi->skipped_atomic_files[BG_GC];
 	si->skipped_atomic_files[FG_GC] = sbi->skipped_atomic_files[FG_GC];
 	si->util_free = (int)(free_user_blocks(sbi) >> sbi->log_blocks_per_seg)
@@ -224,6 +254,7 @@ static void update_mem_info(struct f2fs_sb_info *sbi)
 	si->base_mem += sizeof(struct dirty_seglist_info);
 	si->base_mem += NR_DIRTY_TYPE * f2fs_bitmap_size(MAIN_SEGS(sbi));
 	si->base_mem += f2fs_bitmap_size(MAIN_SECS(sbi));
+	si->base_mem += MAIN_SECS(sbi) * sizeof(struct victim_entry);
 
 	/* build nm */
 	si->base_mem += sizeof(struct f2fs_nm_info);
@@ -377,6 +408,24 @@ static int stat_show(struct seq_file *s, void *v)
 				si->skipped_atomic_files[BG_GC]);
 		seq_printf(s, "BG skip : IO: %u, Other: %u\n",
 				si->io_skip_bggc, si->other_skip_bggc);
+		seq_printf(s, "Victim search : %llu, scanned: %llu, avg: %llu ns\n",
+				si->victim_search, si->victim_scanned,
+				!si->victim_search ? 0 :
+				div64_u64(si->victim_search_ns,
+						si->victim_search));
+		seq_printf(s, "GC time : %llu ms, %llu blocks/s\n",
+				div_u64(si->gc_time_ns, NSEC_PER_MSEC),
+				!si->gc_time_ns ? 0 :
+				div64_u64((u64)si->tot_blks * NSEC_PER_SEC,
+						si->gc_time_ns));
+		seq_puts(s, "Victim index (valid %: sections, oldest age):\n");
+		for (j = 0; j < NR_VICTIM_BUCKETS; j++) {
+			if (!si->victim_secs[j])
+				continue;
+			seq_printf(s, "  - %3d%%: %u, %llu s\n",
+				j * 100 / NR_VICTIM_BUCKETS,
+				si->victim_secs[j], si->victim_age[j]);
+		}
 		seq_puts(s, "\nExtent Cache:\n");
 		seq_printf(s, "  - Hit Count: L1-1:%llu L1-2:%llu L2:%llu\n",
 				si->hit_largest, si->hit_cached,
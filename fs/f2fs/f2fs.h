@@ -1136,6 +1136,9 @@ enum {
 	GC_URGENT,
 };
 
+/* # of valid block ratio buckets in the cost-benefit GC victim index */
+#define NR_VICTIM_BUCKETS	32
+
 enum {
 	WHINT_MODE_OFF,		/* not pass down write hints */
 	WHINT_MODE_USER,	/* try to pass down hints given by users */
@@ -1312,6 +1315,10 @@ struct f2fs_sb_info {
 	int bg_gc;				/* background gc calls */
 	unsigned int io_skip_bggc;		/* skip background gc for in-flight IO */
 	unsigned int other_skip_bggc;		/* skip background gc for other reasons */
+	unsigned long long victim_search;	/* # of victim selections */
+	unsigned long long victim_scanned;	/* # of candidates they checked */
+	unsigned long long victim_search_ns;	/* time spent on them */
+	unsigned long long gc_time_ns;		/* time spent in f2fs_gc */
 	unsigned int ndirty_inode[NR_INODE_TYPE];	/* # of dirty inodes */
 #endif
 	spinlock_t stat_lock;			/* lock for stat operations */
@@ -2215,6 +2222,28 @@ static inline struct bio *f2fs_bio_alloc(struct f2fs_sb_info *sbi,
 	return bio_alloc(GFP_KERNEL, npages);
 }
 
+/*
+ * The block layer counts in-flight requests for the whole disk too, which
+ * also catches I/O to it that doesn't come from this filesystem.
+ */
+static inline bool f2fs_bdev_in_flight(struct block_device *bdev)
+{
+	return part_in_flight(&bdev->bd_disk->part0);
+}
+
+static inline bool f2fs_devices_in_flight(struct f2fs_sb_info *sbi)
+{
+	int i;
+
+	if (!f2fs_is_multi_device(sbi))
+		return f2fs_bdev_in_flight(sbi->sb->s_bdev);
+
+	for (i = 0; i < sbi->s_ndevs; i++)
+		if (f2fs_bdev_in_flight(FDEV(i).bdev))
+			return true;
+	return false;
+}
+
 static inline bool is_idle(struct f2fs_sb_info *sbi, int type)
 {
 	if (sbi->gc_mode == GC_URGENT)
@@ -2235,6 +2264,10 @@ static inline bool is_idle(struct f2fs_sb_info *sbi, int type)
 			atomic_read(&SM_I(sbi)->fcc_info->queued_flush))
 		return false;
 
+	/* background GC must not compete with anyone for the device */
+	if (type == GC_TIME && f2fs_devices_in_flight(sbi))
+		return false;
+
 	return f2fs_time_over(sbi, type);
 }
 
@@ -3272,6 +3305,10 @@ struct f2fs_stat_info {
 	int nr_rd_data, nr_rd_node, nr_rd_meta;
 	int nr_dio_read, nr_dio_write;
 	unsigned int io_skip_bggc, other_skip_bggc;
+	unsigned long long victim_search, victim_scanned, victim_search_ns;
+	unsigned long long gc_time_ns;
+	unsigned int victim_secs[NR_VICTIM_BUCKETS];
+	unsigned long long victim_age[NR_VICTIM_BUCKETS];
 	int nr_flushing, nr_flushed, flush_list_empty;
 	int nr_discarding, nr_discarded;
 	int nr_discard_cmd;
@@ -3311,6 +3348,13 @@ static inline struct f2fs_stat_info *F2FS_STAT(struct f2fs_sb_info *sbi)
 #define stat_inc_bggc_count(sbi)	((sbi)->bg_gc++)
 #define stat_io_skip_bggc_count(sbi)	((sbi)->io_skip_bggc++)
 #define stat_other_skip_bggc_count(sbi)	((sbi)->other_skip_bggc++)
+#define stat_inc_victim_search(sbi, nsearched, ns)			\
+	do {								\
+		(sbi)->victim_search++;					\
+		(sbi)->victim_scanned += (nsearched);			\
+		(sbi)->victim_search_ns += (ns);			\
+	} while (0)
+#define stat_add_gc_time(sbi, ns)	((sbi)->gc_time_ns += (ns))
 #define stat_inc_dirty_inode(sbi, type)	((sbi)->ndirty_inode[type]++)
 #define stat_dec_dirty_inode(sbi, type)	((sbi)->ndirty_inode[type]--)
 #define stat_inc_total_hit(sbi)		(atomic64_inc(&(sbi)->total_hit_ext))
@@ -3429,6 +3473,8 @@ void f2fs_destroy_root_stats(void);
 #define stat_inc_bggc_count(si)				do { } while (0)
 #define stat_io_skip_bggc_count(sbi)			do { } while (0)
 #define stat_other_skip_bggc_count(sbi)			do { } while (0)
+#define stat_inc_victim_search(sbi, nsearched, ns)	do { } while (0)
+#define stat_add_gc_time(sbi, ns)			do { } while (0)
 #define stat_inc_dirty_inode(sbi, type)			do { } while (0)
 #define stat_dec_dirty_inode(sbi, type)			do { } while (0)
 #define stat_inc_total_hit(sb)				do { } while (0)
@@ -242,19 +242,14 @@ static unsigned int check_bg_victims(struct f2fs_sb_info *sbi)
 static unsigned int get_cb_cost(struct f2fs_sb_info *sbi, unsigned int segno)
 {
 	struct sit_info *sit_i = SIT_I(sbi);
-	unsigned int secno = GET_SEC_FROM_SEG(sbi, segno);
-	unsigned int start = GET_SEG_FROM_SEC(sbi, secno);
-	unsigned long long mtime = 0;
+	unsigned long long mtime;
 	unsigned int vblocks;
 	unsigned char age = 0;
 	unsigned char u;
-	unsigned int i;
 
-	for (i = 0; i < sbi->segs_per_sec; i++)
-		mtime += get_seg_entry(sbi, start + i)->mtime;
+	mtime = get_section_mtime(sbi, segno);
 	vblocks = get_valid_blocks(sbi, segno, true);
 
-	mtime = div_u64(mtime, sbi->segs_per_sec);
 	vblocks = div_u64(vblocks, sbi->segs_per_sec);
 
 	u = (vblocks * 100) >> sbi->log_blocks_per_seg;
@@ -284,6 +279,52 @@ static inline unsigned int get_gc_cost(struct f2fs_sb_info *sbi,
 		return get_cb_cost(sbi, segno);
 }
 
+/*
+ * Sections in a victim index bucket have about the same utilization, and the
+ * one at its head is the oldest, so it has the lowest cost-benefit cost of the
+ * bucket. Only the first eligible section of every bucket needs costing.
+ */
+static void get_victim_from_index(struct f2fs_sb_info *sbi,
+			struct victim_sel_policy *p, int gc_type,
+			unsigned int *nsearched)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	struct victim_index *vi = &dirty_i->victim_index;
+	struct victim_entry *ve;
+	unsigned int secno, segno, cost;
+	int i;
+
+	spin_lock(&vi->lock);
+	for (i = 0; i < NR_VICTIM_BUCKETS; i++) {
+		list_for_each_entry(ve, &vi->buckets[i], list) {
+			secno = ve - vi->entries;
+			segno = GET_SEG_FROM_SEC(sbi, secno);
+			(*nsearched)++;
+
+			/* left behind by shrinking resize */
+			if (secno >= MAIN_SECS(sbi))
+				continue;
+			if (sec_usage_check(sbi, secno))
+				continue;
+			/* Don't touch checkpointed data */
+			if (unlikely(is_sbi_flag_set(sbi, SBI_CP_DISABLED) &&
+					get_ckpt_valid_blocks(sbi, segno)))
+				continue;
+			if (gc_type == BG_GC &&
+					test_bit(secno, dirty_i->victim_secmap))
+				continue;
+
+			cost = get_cb_cost(sbi, segno);
+			if (p->min_cost > cost) {
+				p->min_segno = segno;
+				p->min_cost = cost;
+			}
+			break;
+		}
+	}
+	spin_unlock(&vi->lock);
+}
+
 static unsigned int count_bits(const unsigned long *addr,
 				unsigned int offset, unsigned int len)
 {
@@ -313,6 +354,7 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 	unsigned int secno, last_victim;
 	unsigned int last_segment;
 	unsigned int nsearched = 0;
+	u64 start_time = ktime_get_ns();
 
 	mutex_lock(&dirty_i->seglist_lock);
 	last_segment = MAIN_SECS(sbi) * sbi->segs_per_sec;
@@ -356,6 +398,17 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 			goto got_it;
 	}
 
+	/*
+	 * SSR costs segments by their checkpointed valid blocks within its
+	 * own log type, so only LFS cost-benefit selection uses the index.
+	 */
+	if (p.alloc_mode == LFS && p.gc_mode == GC_CB) {
+		get_victim_from_index(sbi, &p, gc_type, &nsearched);
+		if (p.min_segno != NULL_SEGNO)
+			goto got_it;
+		goto out;
+	}
+
 	while (1) {
 		unsigned long cost;
 		unsigned int segno;
@@ -429,6 +482,7 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 		trace_f2fs_get_victim(sbi->sb, type, gc_type, &p,
 				sbi->cur_victim_sec,
 				prefree_segments(sbi), free_segments(sbi));
+	stat_inc_victim_search(sbi, nsearched, ktime_get_ns() - start_time);
 	mutex_unlock(&dirty_i->seglist_lock);
 
 	return (p.min_segno == NULL_SEGNO) ? 0 : 1;
@@ -1241,6 +1295,7 @@ int f2fs_gc(struct f2fs_sb_info *sbi, bool sync,
 	unsigned long long last_skipped = sbi->skipped_atomic_files[FG_GC];
 	unsigned long long first_skipped;
 	unsigned int skipped_round = 0, round = 0;
+	u64 start_time = ktime_get_ns();
 
 	trace_f2fs_gc_begin(sbi->sb, sync, background,
 				get_pages(sbi, F2FS_DIRTY_NODES),
@@ -1329,6 +1384,7 @@ int f2fs_gc(struct f2fs_sb_info *sbi, bool sync,
 stop:
 	SIT_I(sbi)->last_victim[ALLOC_NEXT] = 0;
 	SIT_I(sbi)->last_victim[FLUSH_DEVICE] = init_segno;
+	stat_add_gc_time(sbi, ktime_get_ns() - start_time);
 
 	trace_f2fs_gc_end(sbi->sb, ret, total_freed, sec_freed,
 				get_pages(sbi, F2FS_DIRTY_NODES),
@@ -9,6 +9,7 @@
 #include <linux/f2fs_fs.h>
 #include <linux/bio.h>
 #include <linux/blkdev.h>
+#include <linux/list_sort.h>
 #include <linux/prefetch.h>
 #include <linux/kthread.h>
 #include <linux/swap.h>
@@ -2092,6 +2093,31 @@ static void __set_sit_entry_type(struct f2fs_sb_info *sbi, int type,
 		__mark_sit_entry_dirty(sbi, segno);
 }
 
+/*
+ * Move the section of @segno to the tail of the victim index bucket matching
+ * its valid blocks, as it has just been updated. Called with sentry_lock held.
+ */
+static void update_victim_index(struct f2fs_sb_info *sbi, unsigned int segno)
+{
+	struct victim_index *vi = &DIRTY_I(sbi)->victim_index;
+	struct victim_entry *ve = &vi->entries[GET_SEC_FROM_SEG(sbi, segno)];
+	unsigned char bucket;
+
+	bucket = get_victim_bucket(sbi, get_valid_blocks(sbi, segno, true));
+
+	spin_lock(&vi->lock);
+	if (ve->bucket != VICTIM_NOT_INDEXED) {
+		list_del(&ve->list);
+		vi->nr_secs[ve->bucket]--;
+	}
+	ve->bucket = bucket;
+	if (bucket != VICTIM_NOT_INDEXED) {
+		list_add_tail(&ve->list, &vi->buckets[bucket]);
+		vi->nr_secs[bucket]++;
+	}
+	spin_unlock(&vi->lock);
+}
+
 static void update_sit_entry(struct f2fs_sb_info *sbi, block_t blkaddr, int del)
 {
 	struct seg_entry *se;
@@ -2189,6 +2215,8 @@ static void update_sit_entry(struct f2fs_sb_info *sbi, block_t blkaddr, int del)
 
 	if (__is_large_section(sbi))
 		get_sec_entry(sbi, segno)->valid_blocks += del;
+
+	update_victim_index(sbi, segno);
 }
 
 void f2fs_invalidate_blocks(struct f2fs_sb_info *sbi, block_t addr)
@@ -4245,10 +4273,62 @@ static int init_victim_secmap(struct f2fs_sb_info *sbi)
 	return 0;
 }
 
+static int victim_entry_cmp(void *priv, struct list_head *a,
+						struct list_head *b)
+{
+	struct f2fs_sb_info *sbi = priv;
+	struct victim_entry *entries = DIRTY_I(sbi)->victim_index.entries;
+	struct victim_entry *ve_a = list_entry(a, struct victim_entry, list);
+	struct victim_entry *ve_b = list_entry(b, struct victim_entry, list);
+	unsigned long long mtime_a, mtime_b;
+
+	mtime_a = get_section_mtime(sbi,
+			GET_SEG_FROM_SEC(sbi, (unsigned int)(ve_a - entries)));
+	mtime_b = get_section_mtime(sbi,
+			GET_SEG_FROM_SEC(sbi, (unsigned int)(ve_b - entries)));
+
+	if (mtime_a < mtime_b)
+		return -1;
+	return mtime_a > mtime_b;
+}
+
+static int init_victim_index(struct f2fs_sb_info *sbi)
+{
+	struct victim_index *vi = &DIRTY_I(sbi)->victim_index;
+	struct victim_entry *ve;
+	unsigned int secno;
+	int i;
+
+	vi->entries = f2fs_kvzalloc(sbi, array_size(sizeof(struct victim_entry),
+					MAIN_SECS(sbi)), GFP_KERNEL);
+	if (!vi->entries)
+		return -ENOMEM;
+
+	spin_lock_init(&vi->lock);
+	for (i = 0; i < NR_VICTIM_BUCKETS; i++)
+		INIT_LIST_HEAD(&vi->buckets[i]);
+
+	for (secno = 0; secno < MAIN_SECS(sbi); secno++) {
+		ve = &vi->entries[secno];
+		ve->bucket = get_victim_bucket(sbi, get_valid_blocks(sbi,
+					GET_SEG_FROM_SEC(sbi, secno), true));
+		if (ve->bucket == VICTIM_NOT_INDEXED)
+			continue;
+		list_add_tail(&ve->list, &vi->buckets[ve->bucket]);
+		vi->nr_secs[ve->bucket]++;
+	}
+
+	/* from now on sections are updated in mtime order */
+	for (i = 0; i < NR_VICTIM_BUCKETS; i++)
+		list_sort(sbi, &vi->buckets[i], victim_entry_cmp);
+	return 0;
+}
+
 static int build_dirty_segmap(struct f2fs_sb_info *sbi)
 {
 	struct dirty_seglist_info *dirty_i;
 	unsigned int bitmap_size, i;
+	int err;
 
 	/* allocate memory for dirty segments list information */
 	dirty_i = f2fs_kzalloc(sbi, sizeof(struct dirty_seglist_info),
@@ -4269,7 +4349,10 @@ static int build_dirty_segmap(struct f2fs_sb_info *sbi)
 	}
 
 	init_dirty_segmap(sbi);
-	return init_victim_secmap(sbi);
+	err = init_victim_secmap(sbi);
+	if (err)
+		return err;
+	return init_victim_index(sbi);
 }
 
 static int sanity_check_curseg(struct f2fs_sb_info *sbi)
@@ -4423,6 +4506,7 @@ static void destroy_victim_secmap(struct f2fs_sb_info *sbi)
 {
 	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
 	kvfree(dirty_i->victim_secmap);
+	kvfree(dirty_i->victim_index.entries);
 }
 
 static void destroy_dirty_segmap(struct f2fs_sb_info *sbi)
@@ -271,12 +271,32 @@ enum dirty_type {
 	NR_DIRTY_TYPE
 };
 
+/*
+ * Sections with both valid and invalid blocks, indexed for cost-benefit GC.
+ * They are bucketed by their ratio of valid blocks, and each bucket is kept
+ * in the order its sections were last updated, i.e. oldest mtime first.
+ */
+#define VICTIM_NOT_INDEXED	0xff
+
+struct victim_entry {
+	struct list_head list;		/* in victim_index.buckets */
+	unsigned char bucket;		/* or VICTIM_NOT_INDEXED */
+};
+
+struct victim_index {
+	spinlock_t lock;			/* protects the buckets */
+	struct victim_entry *entries;		/* one per section */
+	struct list_head buckets[NR_VICTIM_BUCKETS];
+	unsigned int nr_secs[NR_VICTIM_BUCKETS];	/* # of sections */
+};
+
 struct dirty_seglist_info {
 	const struct victim_selection *v_ops;	/* victim selction operation */
 	unsigned long *dirty_segmap[NR_DIRTY_TYPE];
 	struct mutex seglist_lock;		/* lock for segment bitmaps */
 	int nr_dirty[NR_DIRTY_TYPE];		/* # of dirty segments */
 	unsigned long *victim_secmap;		/* background GC victims */
+	struct victim_index victim_index;	/* cost-benefit GC victims */
 };
 
 /* victim selection function for cleaning and SSR */
@@ -345,6 +365,28 @@ static inline unsigned int get_ckpt_valid_blocks(struct f2fs_sb_info *sbi,
 	return get_seg_entry(sbi, segno)->ckpt_valid_blocks;
 }
 
+static inline unsigned long long get_section_mtime(struct f2fs_sb_info *sbi,
+				unsigned int segno)
+{
+	unsigned int start = GET_SEG_FROM_SEC(sbi, GET_SEC_FROM_SEG(sbi, segno));
+	unsigned long long mtime = 0;
+	unsigned int i;
+
+	for (i = 0; i < sbi->segs_per_sec; i++)
+		mtime += get_seg_entry(sbi, start + i)->mtime;
+
+	return div_u64(mtime, sbi->segs_per_sec);
+}
+
+static inline unsigned char get_victim_bucket(struct f2fs_sb_info *sbi,
+				unsigned int vblocks)
+{
+	/* free and full sections are never GC victims */
+	if (!vblocks || vblocks >= BLKS_PER_SEC(sbi))
+		return VICTIM_NOT_INDEXED;
+	return vblocks * NR_VICTIM_BUCKETS / BLKS_PER_SEC(sbi);
+}
+
 static inline void seg_info_from_raw_sit(struct seg_entry *se,
 					struct f2fs_sit_entry *rs)
 {
@@ -162,6 +162,14 @@ struct shash_desc {
  * @export: see struct ahash_alg
  * @import: see struct ahash_alg
  * @setkey: see struct ahash_alg
+ * @finup_mb: Finish the hash of several messages of the same length at once,
+ *	      all starting from the state in the operational state handle.
+ *	      Optional, lets implementations interleave the independent hash
+ *	      computations. See crypto_shash_finup_mb().
+ * @mb_max_msgs: Maximum number of messages @finup_mb takes, 1 if it is not
+ *		 implemented.
+ * @mb_tested: Set once the self-test has checked @finup_mb against @finup.
+ *	       Until then crypto_shash_mb_max_msgs() reports one message.
  * @digestsize: see struct ahash_alg
  * @statesize: see struct ahash_alg
  * @descsize: Size of the operational state for the message digest. This state
@@ -182,7 +190,12 @@ struct shash_alg {
 	int (*import)(struct shash_desc *desc, const void *in);
 	int (*setkey)(struct crypto_shash *tfm, const u8 *key,
 		      unsigned int keylen);
+	int (*finup_mb)(struct shash_desc *desc, const u8 * const data[],
+			unsigned int len, u8 * const outs[],
+			unsigned int num_msgs);
 
+	unsigned int mb_max_msgs;
+	bool mb_tested;
 	unsigned int descsize;
 
 	/* These fields must match hash_alg_common. */
@@ -748,6 +761,21 @@ static inline unsigned int crypto_shash_statesize(struct crypto_shash *tfm)
 	return crypto_shash_alg(tfm)->statesize;
 }
 
+/**
+ * crypto_shash_mb_max_msgs() - obtain maximum number of messages per
+ *				crypto_shash_finup_mb() call
+ * @tfm: cipher handle
+ *
+ * Return: maximum number of messages, 1 if the algorithm cannot hash several
+ *	   messages at once or its implementation has not passed the self-test
+ */
+static inline unsigned int crypto_shash_mb_max_msgs(struct crypto_shash *tfm)
+{
+	struct shash_alg *alg = crypto_shash_alg(tfm);
+
+	return alg->mb_tested ? alg->mb_max_msgs : 1;
+}
+
 static inline u32 crypto_shash_get_flags(struct crypto_shash *tfm)
 {
 	return crypto_tfm_get_flags(crypto_shash_tfm(tfm));
@@ -924,6 +952,27 @@ int crypto_shash_final(struct shash_desc *desc, u8 *out);
 int crypto_shash_finup(struct shash_desc *desc, const u8 *data,
 		       unsigned int len, u8 *out);
 
+/**
+ * crypto_shash_finup_mb() - calculate message digests of several buffers
+ * @desc: see crypto_shash_final()
+ * @data: array of @num_msgs buffers, each @len bytes long
+ * @len: length of each buffer
+ * @outs: array of @num_msgs output buffers, see crypto_shash_final()
+ * @num_msgs: number of buffers, at most crypto_shash_mb_max_msgs()
+ *
+ * This function computes the message digest of each buffer as if
+ * crypto_shash_finup was called on a copy of @desc for it. The common prefix
+ * already added to @desc, e.g. a salt, is only hashed once, and the
+ * implementation is free to interleave the independent computations.
+ * Afterwards the state in @desc is undefined.
+ *
+ * Return: 0 if the message digest creation was successful; < 0 if an error
+ *	   occurred
+ */
+int crypto_shash_finup_mb(struct shash_desc *desc, const u8 * const data[],
+			  unsigned int len, u8 * const outs[],
+			  unsigned int num_msgs);
+
 static inline void shash_desc_zero(struct shash_desc *desc)
 {
 	memzero_explicit(desc,
@@ -101,4 +101,22 @@ extern int sysctl_reap_mem_on_sigkill;
 
 /* calls for LMK reaper */
 extern void add_to_oom_reaper(struct task_struct *p);
+
+#ifdef CONFIG_ANDROID_LMK_ADJ_INDEX
+/* lowmemorykiller index of thread group leaders sorted by oom_score_adj */
+static inline void lowmem_adj_index_init(struct task_struct *p)
+{
+	RB_CLEAR_NODE(&p->lmk_adj_node);
+	p->lmk_victim = false;
+}
+
+extern void lowmem_adj_index_add(struct task_struct *p);
+extern void lowmem_adj_index_del(struct task_struct *p);
+extern void lowmem_adj_index_update(struct task_struct *p);
+#else
+static inline void lowmem_adj_index_init(struct task_struct *p) { }
+static inline void lowmem_adj_index_add(struct task_struct *p) { }
+static inline void lowmem_adj_index_del(struct task_struct *p) { }
+static inline void lowmem_adj_index_update(struct task_struct *p) { }
+#endif
 #endif /* _INCLUDE_LINUX_OOM_H */
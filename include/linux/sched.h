@@ -1434,6 +1434,7 @@ struct sched_statistics {
 	u64			wait_max;
 	u64			wait_count;
 	u64			wait_sum;
+	u64			wakeup_start;
 	u64			iowait_count;
 	u64			iowait_sum;
 
@@ -1528,6 +1529,10 @@ struct ravg {
 	 *
 	 * 'busy_buckets' groups historical busy time into different buckets
 	 * used for prediction
+	 *
+	 * 'wake_period' and 'wake_jitter' are running averages of the interval
+	 * between wakeups and of its deviation, used to detect tasks that run
+	 * at a steady cadence such as frame pipelines
 	 */
 	u64 mark_start;
 	u32 sum, demand;
@@ -1538,6 +1543,7 @@ struct ravg {
 	u16 active_windows;
 	u32 pred_demand;
 	u8 busy_buckets[NUM_BUSY_BUCKETS];
+	u32 wake_period, wake_jitter;
 };
 
 struct sched_entity {
@@ -1766,6 +1772,12 @@ struct task_struct {
 #endif
 
 	struct list_head tasks;
+#ifdef CONFIG_ANDROID_LMK_ADJ_INDEX
+	/* lowmemorykiller candidate index, thread group leaders only */
+	struct rb_node lmk_adj_node;
+	short lmk_adj;
+	bool lmk_victim;
+#endif
 #ifdef CONFIG_SMP
 	struct plist_node pushable_tasks;
 	struct rb_node pushable_dl_tasks;
@@ -2737,6 +2749,9 @@ extern int register_cpu_cycle_counter_cb(struct cpu_cycle_counter_cb *cb);
 extern void sched_set_io_is_busy(int val);
 extern int sched_set_group_id(struct task_struct *p, unsigned int group_id);
 extern unsigned int sched_get_group_id(struct task_struct *p);
+extern int sched_set_group_predictor(struct task_struct *p,
+				     unsigned int predictor);
+extern int sched_get_group_predictor(struct task_struct *p);
 extern int sched_set_init_task_load(struct task_struct *p, int init_load_pct);
 extern u32 sched_get_init_task_load(struct task_struct *p);
 extern void sched_update_cpu_freq_min_max(const cpumask_t *cpus, u32 fmin,
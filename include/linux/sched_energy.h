@@ -33,6 +33,17 @@
 
 extern struct sched_group_energy *sge_array[NR_CPUS][NR_SD_LEVELS];
 
+/*
+ * Per CPU lookup from a capacity bucket to the lowest cap_states index
+ * able to serve any capacity within that bucket, built once the energy
+ * model capacities are known.
+ */
+#define SCHED_ENERGY_LUT_SHIFT	4
+#define SCHED_ENERGY_LUT_SIZE	((SCHED_CAPACITY_SCALE >> SCHED_ENERGY_LUT_SHIFT) + 1)
+
+extern u8 sched_energy_lut[NR_CPUS][SCHED_ENERGY_LUT_SIZE];
+extern bool sched_energy_lut_valid;
+
 void init_sched_energy_costs(void);
 
 #else
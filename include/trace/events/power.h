@@ -858,6 +858,36 @@ TRACE_EVENT(sugov_next_freq,
 		      __entry->freq)
 );
 
+TRACE_EVENT(sugov_freq_decide,
+	    TP_PROTO(unsigned int cpu, unsigned int freq),
+	    TP_ARGS(cpu, freq),
+	    TP_STRUCT__entry(
+		    __field(	unsigned int,	cpu)
+		    __field(	unsigned int,	freq)
+	    ),
+	    TP_fast_assign(
+		    __entry->cpu = cpu;
+		    __entry->freq = freq;
+	    ),
+	    TP_printk("cpu=%u freq=%u", __entry->cpu, __entry->freq)
+);
+
+TRACE_EVENT(sugov_freq_apply,
+	    TP_PROTO(unsigned int cpu, unsigned int freq, u64 latency_ns),
+	    TP_ARGS(cpu, freq, latency_ns),
+	    TP_STRUCT__entry(
+		    __field(	unsigned int,	cpu)
+		    __field(	unsigned int,	freq)
+		    __field(	u64,		latency_ns)
+	    ),
+	    TP_fast_assign(
+		    __entry->cpu = cpu;
+		    __entry->freq = freq;
+		    __entry->latency_ns = latency_ns;
+	    ),
+	    TP_printk("cpu=%u freq=%u latency_ns=%llu",
+		      __entry->cpu, __entry->freq, __entry->latency_ns)
+);
 
 #endif /* _TRACE_POWER_H */
 
@@ -652,6 +652,36 @@ TRACE_EVENT(sched_load_to_gov,
 		__entry->sysctl_sched_little_cluster_coloc_fmin_khz,
 		__entry->coloc_boost_load)
 );
+
+/*
+ * Cost of the window rollover work: total runtime and how long all rq
+ * locks were held. Suitable for a hist trigger on held_ns.
+ */
+TRACE_EVENT(sched_walt_irq_work,
+
+	TP_PROTO(bool is_migration, u64 window_start, u64 total_ns,
+		 u64 held_ns),
+
+	TP_ARGS(is_migration, window_start, total_ns, held_ns),
+
+	TP_STRUCT__entry(
+		__field(	bool,		is_migration		)
+		__field(	u64,		window_start		)
+		__field(	u64,		total_ns		)
+		__field(	u64,		held_ns			)
+	),
+
+	TP_fast_assign(
+		__entry->is_migration	= is_migration;
+		__entry->window_start	= window_start;
+		__entry->total_ns	= total_ns;
+		__entry->held_ns	= held_ns;
+	),
+
+	TP_printk("migration=%d window_start=%llu total_ns=%llu held_ns=%llu",
+		__entry->is_migration, __entry->window_start,
+		__entry->total_ns, __entry->held_ns)
+);
 #endif
 
 #ifdef CONFIG_SMP
@@ -1861,6 +1891,36 @@ TRACE_EVENT(core_ctl_eval_need,
 		  __entry->old_need, __entry->new_need, __entry->updated)
 );
 
+TRACE_EVENT(core_ctl_predict_need,
+
+	TP_PROTO(unsigned int cpu, int nrrun, int nr_pred,
+		 unsigned int psi_pct, bool pressured,
+		 unsigned int need, unsigned int pred_need),
+	TP_ARGS(cpu, nrrun, nr_pred, psi_pct, pressured, need, pred_need),
+	TP_STRUCT__entry(
+		__field(u32, cpu)
+		__field(s32, nrrun)
+		__field(s32, nr_pred)
+		__field(u32, psi_pct)
+		__field(u32, pressured)
+		__field(u32, need)
+		__field(u32, pred_need)
+	),
+	TP_fast_assign(
+		__entry->cpu = cpu;
+		__entry->nrrun = nrrun;
+		__entry->nr_pred = nr_pred;
+		__entry->psi_pct = psi_pct;
+		__entry->pressured = pressured;
+		__entry->need = need;
+		__entry->pred_need = pred_need;
+	),
+	TP_printk("cpu=%u, nrrun=%d, nr_pred=%d, psi_pct=%u, pressured=%u, need=%u, pred_need=%u",
+		  __entry->cpu, __entry->nrrun, __entry->nr_pred,
+		  __entry->psi_pct, __entry->pressured, __entry->need,
+		  __entry->pred_need)
+);
+
 TRACE_EVENT(core_ctl_set_busy,
 
 	TP_PROTO(unsigned int cpu, unsigned int busy,
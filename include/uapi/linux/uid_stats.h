@@ -0,0 +1,106 @@
+/*
+ * Binary per-UID statistics exported through procfs.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _UAPI_LINUX_UID_STATS_H
+#define _UAPI_LINUX_UID_STATS_H
+
+#include <linux/types.h>
+
+/*
+ * Every read from offset 0 of a binary UID stats file takes a new snapshot,
+ * made of a struct uid_stats_header followed by nr_records records of
+ * record_size bytes each.
+ *
+ * The first snapshot taken through an open file contains every UID. Later
+ * ones only contain the UIDs whose stats changed since the previous
+ * snapshot taken through the same file, and have UID_STATS_DELTA set.
+ *
+ * Version 1 covers /proc/uid_sys_stats_bin and /proc/uid_time_in_state_bin
+ * only. The concurrent active and policy times stay in the text files
+ * /proc/uid_concurrent_active_time and /proc/uid_concurrent_policy_time,
+ * and any binary form of them will come with a new version.
+ */
+#define UID_STATS_MAGIC		0x53444955	/* "UIDS" */
+#define UID_STATS_VERSION	1
+
+#define UID_STATS_DELTA		(1 << 0)
+
+/**
+ * struct uid_stats_header - start of every snapshot
+ * @magic:	UID_STATS_MAGIC
+ * @version:	UID_STATS_VERSION
+ * @flags:	UID_STATS_* flags
+ * @record_size: size in bytes of each record
+ * @nr_records:	number of records following the header
+ * @nr_states:	number of time_in_state entries per record, 0 if none
+ * @pad:	padding for 64-bit alignment, always zero
+ * @generation:	snapshot generation, increases with every snapshot taken
+ */
+struct uid_stats_header {
+	__u32	magic;
+	__u16	version;
+	__u16	flags;
+	__u32	record_size;
+	__u32	nr_records;
+	__u32	nr_states;
+	__u32	pad;
+	__u64	generation;
+};
+
+/**
+ * struct uid_io_record_stats - I/O done while in one uid_procstat state
+ * @rchar:	bytes read
+ * @wchar:	bytes written
+ * @read_bytes:	bytes read from storage
+ * @write_bytes: bytes written to storage
+ * @fsync:	number of fsync calls
+ */
+struct uid_io_record_stats {
+	__u64	rchar;
+	__u64	wchar;
+	__u64	read_bytes;
+	__u64	write_bytes;
+	__u64	fsync;
+};
+
+#define UID_IO_RECORD_FOREGROUND	0
+#define UID_IO_RECORD_BACKGROUND	1
+#define UID_IO_RECORD_STATES		2
+
+/**
+ * struct uid_sys_stats_record - /proc/uid_sys_stats_bin record
+ * @uid:	UID
+ * @pad:	padding for 64-bit alignment, always zero
+ * @utime_us:	user time in microseconds, as in /proc/uid_cputime/show_uid_stat
+ * @stime_us:	system time in microseconds
+ * @io:		I/O stats per state, as in /proc/uid_io/stats
+ */
+struct uid_sys_stats_record {
+	__u32	uid;
+	__u32	pad;
+	__u64	utime_us;
+	__u64	stime_us;
+	struct uid_io_record_stats io[UID_IO_RECORD_STATES];
+};
+
+/**
+ * struct uid_time_in_state_record - /proc/uid_time_in_state_bin record
+ * @uid:	UID
+ * @pad:	padding for 64-bit alignment, always zero
+ * @time_in_state: nr_states times in clock ticks, in the column order of
+ *		/proc/uid_time_in_state
+ */
+struct uid_time_in_state_record {
+	__u32	uid;
+	__u32	pad;
+	__u64	time_in_state[0];
+};
+
+#endif /* _UAPI_LINUX_UID_STATS_H */
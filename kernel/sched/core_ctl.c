@@ -20,6 +20,7 @@
 #include <linux/sched.h>
 #include <linux/sched/rt.h>
 #include <linux/syscore_ops.h>
+#include <linux/psi.h>
 
 #include <trace/events/sched.h>
 #include "sched.h"
@@ -58,6 +59,14 @@ struct cluster_data {
 	unsigned int first_cpu;
 	unsigned int boost;
 	struct kobject kobj;
+	bool predictive;
+	unsigned int psi_up_thres;
+	unsigned int psi_down_thres;
+	unsigned int idle_offline_delay_ms;
+	unsigned int psi_pct;
+	bool pressured;
+	bool predict_idle;
+	int prev_nrrun;
 };
 
 struct cpu_data {
@@ -68,6 +77,8 @@ struct cpu_data {
 	struct cluster_data *cluster;
 	struct list_head sib;
 	bool isolated_by_us;
+	unsigned int psi_pct;
+	u32 psi_some_prev;
 };
 
 static DEFINE_PER_CPU(struct cpu_data, cpu_state);
@@ -282,6 +293,94 @@ static ssize_t show_enable(const struct cluster_data *state, char *buf)
 	return scnprintf(buf, PAGE_SIZE, "%u\n", state->enable);
 }
 
+static ssize_t store_predictive(struct cluster_data *state,
+				const char *buf, size_t count)
+{
+	unsigned int val;
+	bool bval;
+
+	if (sscanf(buf, "%u\n", &val) != 1)
+		return -EINVAL;
+
+	bval = !!val;
+	if (bval != state->predictive) {
+		state->predictive = bval;
+		apply_need(state);
+	}
+
+	return count;
+}
+
+static ssize_t show_predictive(const struct cluster_data *state, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", state->predictive);
+}
+
+static ssize_t store_psi_up_thres(struct cluster_data *state,
+				  const char *buf, size_t count)
+{
+	unsigned int val;
+
+	if (sscanf(buf, "%u\n", &val) != 1)
+		return -EINVAL;
+
+	if (val > 100 || val < state->psi_down_thres)
+		return -EINVAL;
+
+	state->psi_up_thres = val;
+	apply_need(state);
+
+	return count;
+}
+
+static ssize_t show_psi_up_thres(const struct cluster_data *state, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%u\n", state->psi_up_thres);
+}
+
+static ssize_t store_psi_down_thres(struct cluster_data *state,
+				    const char *buf, size_t count)
+{
+	unsigned int val;
+
+	if (sscanf(buf, "%u\n", &val) != 1)
+		return -EINVAL;
+
+	if (val > state->psi_up_thres)
+		return -EINVAL;
+
+	state->psi_down_thres = val;
+	apply_need(state);
+
+	return count;
+}
+
+static ssize_t show_psi_down_thres(const struct cluster_data *state,
+				   char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%u\n", state->psi_down_thres);
+}
+
+static ssize_t store_idle_offline_delay_ms(struct cluster_data *state,
+					   const char *buf, size_t count)
+{
+	unsigned int val;
+
+	if (sscanf(buf, "%u\n", &val) != 1)
+		return -EINVAL;
+
+	state->idle_offline_delay_ms = val;
+	apply_need(state);
+
+	return count;
+}
+
+static ssize_t show_idle_offline_delay_ms(const struct cluster_data *state,
+					  char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%u\n", state->idle_offline_delay_ms);
+}
+
 static ssize_t show_need_cpus(const struct cluster_data *state, char *buf)
 {
 	return snprintf(buf, PAGE_SIZE, "%u\n", state->need_cpus);
@@ -337,6 +436,8 @@ static ssize_t show_global_state(const struct cluster_data *state, char *buf)
 						cluster->nr_isolated_cpus);
 		count += snprintf(buf + count, PAGE_SIZE - count,
 				"\tBoost: %u\n", (unsigned int) cluster->boost);
+		count += snprintf(buf + count, PAGE_SIZE - count,
+				"\tCPU pressure%%: %u\n", c->psi_pct);
 	}
 	spin_unlock_irq(&state_lock);
 
@@ -416,6 +517,10 @@ core_ctl_attr_ro(active_cpus);
 core_ctl_attr_ro(global_state);
 core_ctl_attr_rw(not_preferred);
 core_ctl_attr_rw(enable);
+core_ctl_attr_rw(predictive);
+core_ctl_attr_rw(psi_up_thres);
+core_ctl_attr_rw(psi_down_thres);
+core_ctl_attr_rw(idle_offline_delay_ms);
 
 static struct attribute *default_attrs[] = {
 	&min_cpus.attr,
@@ -430,6 +535,10 @@ static struct attribute *default_attrs[] = {
 	&active_cpus.attr,
 	&global_state.attr,
 	&not_preferred.attr,
+	&predictive.attr,
+	&psi_up_thres.attr,
+	&psi_down_thres.attr,
+	&idle_offline_delay_ms.attr,
 	NULL
 };
 
@@ -488,6 +597,7 @@ static void update_running_avg(void)
 	for_each_cluster(cluster, index) {
 		if (!cluster->inited)
 			continue;
+		cluster->prev_nrrun = cluster->nrrun;
 		cluster->nrrun = cluster->is_big_cluster ? big_avg : avg;
 		cluster->max_nr = cluster->is_big_cluster ? big_max_nr : max_nr;
 	}
@@ -518,6 +628,68 @@ static unsigned int apply_task_need(const struct cluster_data *cluster,
 	return new_need;
 }
 
+/* ======================= predictive core count  ===================== */
+
+/*
+ * Share of the last window that runnable tasks on @c spent waiting for
+ * the CPU, from the system-wide PSI "some" CPU state.
+ */
+static unsigned int sample_psi_pct(struct cpu_data *c, u64 window_ns)
+{
+	u32 now = psi_cpu_some_time(c->cpu);
+	u32 delta = now - c->psi_some_prev;
+
+	c->psi_some_prev = now;
+	if (!window_ns)
+		return 0;
+
+	return min_t(u64, div64_u64((u64)delta * 100, window_ns), 100);
+}
+
+/*
+ * Raise the need ahead of the load instead of after it. CPU pressure above
+ * psi_up_thres means tasks are already queueing, so one more CPU is
+ * brought in right away; the cluster stays pressured until the pressure
+ * drops below psi_down_thres. The nr_running average is extrapolated one
+ * window ahead and a rising trend earns one more CPU as well. A cluster
+ * with no pressure and a flat or falling trend is marked idle, which lets
+ * eval_need() isolate after idle_offline_delay_ms.
+ */
+static unsigned int apply_predicted_need(struct cluster_data *cluster,
+					 unsigned int need)
+{
+	unsigned int pred_need = need;
+	unsigned int psi_pct = 0;
+	struct cpu_data *c;
+	int nr_pred;
+
+	list_for_each_entry(c, &cluster->lru, sib)
+		psi_pct = max(psi_pct, c->psi_pct);
+	cluster->psi_pct = psi_pct;
+
+	if (psi_pct >= cluster->psi_up_thres)
+		cluster->pressured = true;
+	else if (psi_pct < cluster->psi_down_thres)
+		cluster->pressured = false;
+
+	if (cluster->pressured)
+		pred_need++;
+
+	nr_pred = 2 * cluster->nrrun - cluster->prev_nrrun;
+	if (cluster->nrrun > cluster->prev_nrrun && nr_pred > (int)pred_need)
+		pred_need++;
+
+	/* below psi_down_thres also means the cluster is not pressured */
+	cluster->predict_idle = psi_pct < cluster->psi_down_thres &&
+				cluster->nrrun <= cluster->prev_nrrun;
+
+	trace_core_ctl_predict_need(cluster->first_cpu, cluster->nrrun,
+				    nr_pred, psi_pct, cluster->pressured,
+				    need, pred_need);
+
+	return pred_need;
+}
+
 /* ======================= load based core count  ====================== */
 
 static unsigned int apply_limits(const struct cluster_data *cluster,
@@ -578,6 +750,8 @@ static bool eval_need(struct cluster_data *cluster)
 			need_cpus += c->is_busy;
 		}
 		need_cpus = apply_task_need(cluster, need_cpus);
+		if (cluster->predictive)
+			need_cpus = apply_predicted_need(cluster, need_cpus);
 	}
 	new_need = apply_limits(cluster, need_cpus);
 	need_flag = adjustment_possible(cluster, new_need);
@@ -600,7 +774,11 @@ static bool eval_need(struct cluster_data *cluster)
 		}
 
 		elapsed =  now - cluster->need_ts;
-		ret = elapsed >= cluster->offline_delay_ms;
+		if (cluster->predictive && cluster->predict_idle)
+			ret = elapsed >= min(cluster->offline_delay_ms,
+					     cluster->idle_offline_delay_ms);
+		else
+			ret = elapsed >= cluster->offline_delay_ms;
 	}
 
 	if (ret) {
@@ -682,6 +860,7 @@ void core_ctl_check(u64 window_start)
 	struct cluster_data *cluster;
 	unsigned int index = 0;
 	unsigned long flags;
+	u64 window_ns;
 
 	if (unlikely(!initialized))
 		return;
@@ -689,6 +868,7 @@ void core_ctl_check(u64 window_start)
 	if (window_start == core_ctl_check_timestamp)
 		return;
 
+	window_ns = window_start - core_ctl_check_timestamp;
 	core_ctl_check_timestamp = window_start;
 
 	spin_lock_irqsave(&state_lock, flags);
@@ -701,6 +881,7 @@ void core_ctl_check(u64 window_start)
 			continue;
 
 		c->busy = sched_get_cpu_util(cpu);
+		c->psi_pct = sample_psi_pct(c, window_ns);
 	}
 	spin_unlock_irqrestore(&state_lock, flags);
 
@@ -1130,6 +1311,10 @@ static int cluster_init(const struct cpumask *mask)
 	cluster->offline_delay_ms = 100;
 	cluster->task_thres = UINT_MAX;
 	cluster->nrrun = cluster->num_cpus;
+	cluster->prev_nrrun = cluster->nrrun;
+	cluster->psi_up_thres = 20;
+	cluster->psi_down_thres = 5;
+	cluster->idle_offline_delay_ms = 20;
 #ifdef CONFIG_SCHED_CORE_ROTATE
 	cluster->set_max = cluster->num_cpus * cluster->num_cpus;
 	/* by default mark all cpus as eligible */
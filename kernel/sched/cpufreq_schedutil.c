@@ -47,10 +47,10 @@ struct sugov_policy {
 	unsigned long avg_cap;
 	unsigned int next_freq;
 	unsigned int cached_raw_freq;
+	u64 decide_ns;
 	unsigned long hispeed_util;
 	unsigned long max;
 
-	/* The next fields are only needed if fast switch cannot be used. */
 	struct irq_work irq_work;
 	struct kthread_work work;
 	struct mutex work_lock;
@@ -134,8 +134,6 @@ static bool sugov_up_down_rate_limit(struct sugov_policy *sg_policy, u64 time,
 static void sugov_update_commit(struct sugov_policy *sg_policy, u64 time,
 				unsigned int next_freq)
 {
-	struct cpufreq_policy *policy = sg_policy->policy;
-
 	if (sg_policy->next_freq == next_freq)
 		return;
 
@@ -145,17 +143,12 @@ static void sugov_update_commit(struct sugov_policy *sg_policy, u64 time,
 	sg_policy->next_freq = next_freq;
 	sg_policy->last_freq_update_time = time;
 
-	if (policy->fast_switch_enabled) {
-		next_freq = cpufreq_driver_fast_switch(policy, next_freq);
-		if (next_freq == CPUFREQ_ENTRY_INVALID)
-			return;
+	if (trace_sugov_freq_apply_enabled())
+		sg_policy->decide_ns = ktime_get_ns();
+	trace_sugov_freq_decide(sg_policy->policy->cpu, next_freq);
 
-		policy->cur = next_freq;
-		trace_cpu_frequency(next_freq, smp_processor_id());
-	} else {
-		sg_policy->work_in_progress = true;
-		sched_irq_work_queue(&sg_policy->irq_work);
-	}
+	sg_policy->work_in_progress = true;
+	sched_irq_work_queue(&sg_policy->irq_work);
 }
 
 #define TARGET_LOAD 80
@@ -415,16 +408,16 @@ static unsigned int sugov_next_freq_shared(struct sugov_cpu *sg_cpu, u64 time)
 		 * enough, don't take the CPU into account as it probably is
 		 * idle now (and clear iowait_boost for it).
 		 */
-		delta_ns = time - j_sg_cpu->last_update;
+		delta_ns = time - READ_ONCE(j_sg_cpu->last_update);
 		if (delta_ns > stale_ns) {
 			j_sg_cpu->iowait_boost = 0;
 			continue;
 		}
-		if (j_sg_cpu->flags & SCHED_CPUFREQ_RT_DL)
+		if (READ_ONCE(j_sg_cpu->flags) & SCHED_CPUFREQ_RT_DL)
 			return policy->cpuinfo.max_freq;
 
-		j_util = j_sg_cpu->util;
-		j_max = j_sg_cpu->max;
+		j_util = READ_ONCE(j_sg_cpu->util);
+		j_max = READ_ONCE(j_sg_cpu->max);
 		if (j_util * max >= j_max * util) {
 			util = j_util;
 			max = j_max;
@@ -437,6 +430,26 @@ static unsigned int sugov_next_freq_shared(struct sugov_cpu *sg_cpu, u64 time)
 	return get_next_freq(sg_policy, util, max);
 }
 
+/*
+ * Lockless pre-check for sugov_update_shared(): true when the policy lock
+ * has work to do, either because policy-wide state is out of date or
+ * because the rate limit allows a new frequency decision.
+ */
+static bool sugov_shared_update_due(struct sugov_policy *sg_policy,
+				    struct sugov_cpu *sg_cpu, u64 time,
+				    unsigned long max)
+{
+	s64 delta_ns;
+
+	if (READ_ONCE(sg_policy->need_freq_update) ||
+	    READ_ONCE(sg_policy->max) != max ||
+	    sg_cpu->walt_load.ws > READ_ONCE(sg_policy->last_ws))
+		return true;
+
+	delta_ns = time - READ_ONCE(sg_policy->last_freq_update_time);
+	return delta_ns >= sg_policy->min_rate_limit_ns;
+}
+
 static void sugov_update_shared(struct update_util_data *hook, u64 time,
 				unsigned int flags)
 {
@@ -452,8 +465,38 @@ static void sugov_update_shared(struct update_util_data *hook, u64 time,
 
 	flags &= ~SCHED_CPUFREQ_RT_DL;
 
+	/*
+	 * The per-CPU fields are only ever written by this CPU and the
+	 * aggregation in sugov_next_freq_shared() tolerates a stale value,
+	 * so publish them without the policy lock. The lock is only taken
+	 * when there is policy-wide state to update or a frequency decision
+	 * is due, which keeps rate-limited updates off the shared lock.
+	 *
+	 * iowait_boost is also cleared and decayed by other CPUs under the
+	 * lock, so any update that may touch it takes the lock as well.
+	 * Without a boost or an IOWAIT flag sugov_set_iowait_boost() would
+	 * not change anything.
+	 */
+	WRITE_ONCE(sg_cpu->util, util);
+	WRITE_ONCE(sg_cpu->max, max);
+	WRITE_ONCE(sg_cpu->flags, flags);
+
+	trace_sugov_util_update(sg_cpu->cpu, util, sg_policy->avg_cap,
+				max, sg_cpu->walt_load.nl,
+				sg_cpu->walt_load.pl, flags);
+
+	if (!(flags & SCHED_CPUFREQ_IOWAIT) &&
+	    !READ_ONCE(sg_cpu->iowait_boost) &&
+	    !sugov_shared_update_due(sg_policy, sg_cpu, time, max)) {
+		WRITE_ONCE(sg_cpu->last_update, time);
+		return;
+	}
+
 	raw_spin_lock(&sg_policy->update_lock);
 
+	sugov_set_iowait_boost(sg_cpu, time, flags);
+	WRITE_ONCE(sg_cpu->last_update, time);
+
 	if (sg_policy->max != max) {
 		sg_policy->max = max;
 		hs_util = freq_to_util(sg_policy,
@@ -462,20 +505,9 @@ static void sugov_update_shared(struct update_util_data *hook, u64 time,
 		sg_policy->hispeed_util = hs_util;
 	}
 
-	sg_cpu->util = util;
-	sg_cpu->max = max;
-	sg_cpu->flags = flags;
-
-	sugov_set_iowait_boost(sg_cpu, time, flags);
-	sg_cpu->last_update = time;
-
 	sugov_calc_avg_cap(sg_policy, sg_cpu->walt_load.ws,
 			   sg_policy->policy->cur);
 
-	trace_sugov_util_update(sg_cpu->cpu, sg_cpu->util, sg_policy->avg_cap,
-				max, sg_cpu->walt_load.nl,
-				sg_cpu->walt_load.pl, flags);
-
 	if (sugov_should_update_freq(sg_policy, time)) {
 		if (flags & SCHED_CPUFREQ_RT_DL)
 			next_f = sg_policy->policy->cpuinfo.max_freq;
@@ -500,6 +532,10 @@ static void sugov_work(struct kthread_work *work)
 	raw_spin_unlock_irqrestore(&sg_policy->update_lock, flags);
 	__cpufreq_driver_target(sg_policy->policy, sg_policy->next_freq,
 				CPUFREQ_RELATION_L);
+	if (trace_sugov_freq_apply_enabled())
+		trace_sugov_freq_apply(sg_policy->policy->cpu,
+				       sg_policy->policy->cur,
+				       ktime_get_ns() - sg_policy->decide_ns);
 	mutex_unlock(&sg_policy->work_lock);
 
 	sg_policy->work_in_progress = false;
@@ -720,10 +756,6 @@ static int sugov_kthread_create(struct sugov_policy *sg_policy)
 	struct cpufreq_policy *policy = sg_policy->policy;
 	int ret;
 
-	/* kthread only required for slow path */
-	if (policy->fast_switch_enabled)
-		return 0;
-
 	kthread_init_work(&sg_policy->work, sugov_work);
 	kthread_init_worker(&sg_policy->worker);
 	thread = kthread_create(kthread_worker_fn, &sg_policy->worker,
@@ -753,10 +785,6 @@ static int sugov_kthread_create(struct sugov_policy *sg_policy)
 
 static void sugov_kthread_stop(struct sugov_policy *sg_policy)
 {
-	/* kthread only required for slow path */
-	if (sg_policy->policy->fast_switch_enabled)
-		return;
-
 	kthread_flush_worker(&sg_policy->worker);
 	kthread_stop(sg_policy->thread);
 	mutex_destroy(&sg_policy->work_lock);
@@ -835,12 +863,10 @@ static int sugov_init(struct cpufreq_policy *policy)
 	if (policy->governor_data)
 		return -EBUSY;
 
-	cpufreq_enable_fast_switch(policy);
-
 	sg_policy = sugov_policy_alloc(policy);
 	if (!sg_policy) {
 		ret = -ENOMEM;
-		goto disable_fast_switch;
+		goto out_err;
 	}
 
 	ret = sugov_kthread_create(sg_policy);
@@ -905,9 +931,7 @@ static int sugov_init(struct cpufreq_policy *policy)
 
 	sugov_policy_free(sg_policy);
 
-disable_fast_switch:
-	cpufreq_disable_fast_switch(policy);
-
+out_err:
 	pr_err("initialization failed (error %d)\n", ret);
 	return ret;
 }
@@ -931,7 +955,6 @@ static void sugov_exit(struct cpufreq_policy *policy)
 
 	sugov_kthread_stop(sg_policy);
 	sugov_policy_free(sg_policy);
-	cpufreq_disable_fast_switch(policy);
 }
 
 static int sugov_start(struct cpufreq_policy *policy)
@@ -981,10 +1004,8 @@ static void sugov_stop(struct cpufreq_policy *policy)
 
 	synchronize_sched();
 
-	if (!policy->fast_switch_enabled) {
-		irq_work_sync(&sg_policy->irq_work);
-		kthread_cancel_work_sync(&sg_policy->work);
-	}
+	irq_work_sync(&sg_policy->irq_work);
+	kthread_cancel_work_sync(&sg_policy->work);
 }
 
 static void sugov_limits(struct cpufreq_policy *policy)
@@ -992,15 +1013,13 @@ static void sugov_limits(struct cpufreq_policy *policy)
 	struct sugov_policy *sg_policy = policy->governor_data;
 	unsigned long flags;
 
-	if (!policy->fast_switch_enabled) {
-		mutex_lock(&sg_policy->work_lock);
-		raw_spin_lock_irqsave(&sg_policy->update_lock, flags);
-		sugov_track_cycles(sg_policy, sg_policy->policy->cur,
-				   sched_ktime_clock());
-		raw_spin_unlock_irqrestore(&sg_policy->update_lock, flags);
-		cpufreq_policy_apply_limits(policy);
-		mutex_unlock(&sg_policy->work_lock);
-	}
+	mutex_lock(&sg_policy->work_lock);
+	raw_spin_lock_irqsave(&sg_policy->update_lock, flags);
+	sugov_track_cycles(sg_policy, sg_policy->policy->cur,
+			   sched_ktime_clock());
+	raw_spin_unlock_irqrestore(&sg_policy->update_lock, flags);
+	cpufreq_policy_apply_limits(policy);
+	mutex_unlock(&sg_policy->work_lock);
 
 	sg_policy->need_freq_update = true;
 }
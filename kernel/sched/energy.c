@@ -33,6 +33,9 @@
 
 struct sched_group_energy *sge_array[NR_CPUS][NR_SD_LEVELS];
 
+u8 sched_energy_lut[NR_CPUS][SCHED_ENERGY_LUT_SIZE];
+bool sched_energy_lut_valid;
+
 static void free_resources(void)
 {
 	int cpu, sd_level;
@@ -155,6 +158,54 @@ void init_sched_energy_costs(void)
 	free_resources();
 }
 
+/*
+ * Precompute, for each CPU, the capacity -> cap_states index mapping used
+ * by the energy-aware wakeup fast path. Every bucket maps to the first
+ * capacity state whose capacity covers the bottom of the bucket, so the
+ * lookup only ever has to step forward from there.
+ */
+static void build_energy_lut(void)
+{
+	struct sched_group_energy *sge, *sge_l;
+	int cpu, sd_level, b, idx;
+
+	WRITE_ONCE(sched_energy_lut_valid, false);
+
+	for_each_possible_cpu(cpu) {
+		sge = sge_array[cpu][SD_LEVEL0];
+		if (!sge || !sge->nr_cap_states || sge->nr_cap_states > U8_MAX)
+			return;
+
+		/*
+		 * All levels must share the same capacity states, otherwise
+		 * an index from the LUT means a different OPP at the cluster
+		 * level and compute_energy() has to be used.
+		 */
+		for_each_possible_sd_level(sd_level) {
+			sge_l = sge_array[cpu][sd_level];
+			if (!sge_l)
+				break;
+			if (sge_l->nr_cap_states != sge->nr_cap_states)
+				return;
+			for (idx = 0; idx < sge->nr_cap_states; idx++)
+				if (sge_l->cap_states[idx].cap !=
+				    sge->cap_states[idx].cap)
+					return;
+		}
+
+		for (b = 0, idx = 0; b < SCHED_ENERGY_LUT_SIZE; b++) {
+			unsigned long cap = b << SCHED_ENERGY_LUT_SHIFT;
+
+			while (idx < sge->nr_cap_states - 1 &&
+			       sge->cap_states[idx].cap < cap)
+				idx++;
+			sched_energy_lut[cpu][b] = idx;
+		}
+	}
+
+	WRITE_ONCE(sched_energy_lut_valid, true);
+}
+
 static int sched_energy_probe(struct platform_device *pdev)
 {
 	unsigned long max_freq = 0;
@@ -286,6 +337,8 @@ static int sched_energy_probe(struct platform_device *pdev)
 	kfree(max_frequencies);
 
 	if (is_sge_valid) {
+		build_energy_lut();
+
 		/*
 		 * Sched_domains might have built with default cpu capacity
 		 * values on bootup.
@@ -1056,8 +1056,36 @@ update_stats_enqueue(struct cfs_rq *cfs_rq, struct sched_entity *se, int flags)
 	if (se != cfs_rq->curr)
 		update_stats_wait_start(cfs_rq, se);
 
-	if (flags & ENQUEUE_WAKEUP)
+	if (flags & ENQUEUE_WAKEUP) {
 		update_stats_enqueue_sleeper(cfs_rq, se);
+
+		if (se != cfs_rq->curr && entity_is_task(se))
+			schedstat_set(se->statistics.wakeup_start,
+				      rq_clock(rq_of(cfs_rq)));
+	}
+}
+
+/*
+ * Task picked to run - account the latency from its last wakeup to its
+ * schedtune group:
+ */
+static inline void
+update_stats_wakeup_end(struct cfs_rq *cfs_rq, struct sched_entity *se)
+{
+	u64 start;
+	s64 delta;
+
+	if (!schedstat_enabled() || !entity_is_task(se))
+		return;
+
+	start = schedstat_val(se->statistics.wakeup_start);
+	if (!start)
+		return;
+
+	schedstat_set(se->statistics.wakeup_start, 0);
+	delta = rq_clock(rq_of(cfs_rq)) - start;
+	if (delta > 0)
+		schedtune_wakeup_latency(task_of(se), delta);
 }
 
 static inline void
@@ -3894,6 +3922,7 @@ set_next_entity(struct cfs_rq *cfs_rq, struct sched_entity *se)
 		 * runqueue.
 		 */
 		update_stats_wait_end(cfs_rq, se);
+		update_stats_wakeup_end(cfs_rq, se);
 		__dequeue_entity(cfs_rq, se);
 		update_load_avg(se, UPDATE_TG);
 	}
@@ -5838,6 +5867,44 @@ static int find_new_capacity(struct energy_env *eenv, int cpu_idx)
 	return eenv->cpu[cpu_idx].cap_idx;
 }
 
+/*
+ * Estimate the idle state @sg ends up in when a task migration into or out
+ * of it leaves the group with @grp_util total utilization.
+ */
+static int group_idle_state_moved(struct sched_group *sg, long grp_util)
+{
+	int max_idle_state_idx, new_state;
+
+	if (grp_util >
+		((long)sg->sgc->max_capacity * (int)sg->group_weight)) {
+		/* After moving, the group will be fully occupied
+		 * so assume it will not be idle at all.
+		 */
+		return 0;
+	}
+
+	/* after moving, this group is at most partly
+	 * occupied, so it should have some idle time.
+	 */
+	max_idle_state_idx = sg->sge->nr_idle_states - 2;
+	new_state = grp_util * max_idle_state_idx;
+	if (grp_util <= 0)
+		/* group will have no util, use lowest state */
+		new_state = max_idle_state_idx + 1;
+	else {
+		/* for partially idle, linearly map util to idle
+		 * states, excluding the lowest one. This does not
+		 * correspond to the state we expect to enter in
+		 * reality, but an indication of what might happen.
+		 */
+		new_state = min(max_idle_state_idx, (int)
+				(new_state / sg->sgc->max_capacity));
+		new_state = max_idle_state_idx - new_state;
+	}
+
+	return new_state;
+}
+
 static int group_idle_state(struct energy_env *eenv, int cpu_idx)
 {
 	struct sched_group *sg = eenv->sg;
@@ -5876,33 +5943,7 @@ static int group_idle_state(struct energy_env *eenv, int cpu_idx)
 			grp_util += eenv->util_delta;
 	}
 
-	if (grp_util <=
-		((long)sg->sgc->max_capacity * (int)sg->group_weight)) {
-		/* after moving, this group is at most partly
-		 * occupied, so it should have some idle time.
-		 */
-		int max_idle_state_idx = sg->sge->nr_idle_states - 2;
-		int new_state = grp_util * max_idle_state_idx;
-		if (grp_util <= 0)
-			/* group will have no util, use lowest state */
-			new_state = max_idle_state_idx + 1;
-		else {
-			/* for partially idle, linearly map util to idle
-			 * states, excluding the lowest one. This does not
-			 * correspond to the state we expect to enter in
-			 * reality, but an indication of what might happen.
-			 */
-			new_state = min(max_idle_state_idx, (int)
-					(new_state / sg->sgc->max_capacity));
-			new_state = max_idle_state_idx - new_state;
-		}
-		state = new_state;
-	} else {
-		/* After moving, the group will be fully occupied
-		 * so assume it will not be idle at all.
-		 */
-		state = 0;
-	}
+	state = group_idle_state_moved(sg, grp_util);
 end:
 	return state;
 }
@@ -6075,6 +6116,148 @@ static inline bool cpu_in_sg(struct sched_group *sg, int cpu)
 	return cpu != -1 && cpumask_test_cpu(cpu, sched_group_cpus(sg));
 }
 
+/* Largest frequency domain handled by compute_energy_lut() */
+#define EAS_LUT_MAX_CPUS	8
+
+/*
+ * find_new_capacity() for a known max utilization: start from the capacity
+ * state precomputed for util's bucket and step forward to the exact one.
+ */
+static inline int energy_lut_cap_idx(const struct sched_group_energy *sge,
+				     int cpu, unsigned long util)
+{
+	int max_idx = sge->nr_cap_states - 1;
+	int idx;
+
+	idx = sched_energy_lut[cpu][min_t(unsigned long,
+				util >> SCHED_ENERGY_LUT_SHIFT,
+				SCHED_ENERGY_LUT_SIZE - 1)];
+	while (idx < max_idx && sge->cap_states[idx].cap < util)
+		idx++;
+
+	return idx;
+}
+
+/*
+ * compute_energy_lut() is compute_energy() for the common two level energy
+ * model, where the frequency domain (sd_scs) has one group per CPU and is
+ * itself the top energy-aware group. It gives the same result, but samples
+ * each CPU's utilization once rather than once per candidate and level,
+ * looks the OPP up in sched_energy_lut and doesn't walk the sched domains.
+ *
+ * Returns -EAGAIN, before touching eenv, when the topology below @cpu
+ * doesn't match and compute_energy() has to be used instead.
+ */
+static int compute_energy_lut(struct energy_env *eenv, int cpu)
+{
+	struct sched_group *sgs[EAS_LUT_MAX_CPUS];
+	unsigned long util[EAS_LUT_MAX_CPUS];
+	int state[EAS_LUT_MAX_CPUS];
+	unsigned long max_util = 0;
+	long sum_util = 0;
+	int cl_state = INT_MAX;
+	struct sched_group *sg_cl, *sg;
+	struct sched_domain *sd;
+	int src_cpu = eenv->cpu[EAS_CPU_PRV].cpu_id;
+	int cpu_idx, nr = 0, n;
+
+	sd = rcu_dereference(per_cpu(sd_scs, cpu));
+	if (!sd || sd->child || !sd->parent ||
+	    rcu_dereference(per_cpu(sd_ea, cpu)) != sd->parent)
+		return -EAGAIN;
+
+	sg_cl = sd->parent->groups;
+
+	sg = sd->groups;
+	do {
+		int i = group_first_cpu(sg);
+
+		if (nr == EAS_LUT_MAX_CPUS || sg->group_weight != 1 || !sg->sge)
+			return -EAGAIN;
+
+		sgs[nr] = sg;
+		util[nr] = cpu_util_wake(i, eenv->p);
+		state[nr] = idle_get_state_idx(cpu_rq(i));
+
+		max_util = max(max_util, util[nr]);
+		max_util = max(max_util, capacity_min_of(i));
+		sum_util += util[nr];
+		cl_state = min(cl_state, state[nr]);
+		nr++;
+	} while (sg = sg->next, sg != sd->groups);
+
+	if (nr != sg_cl->group_weight)
+		return -EAGAIN;
+
+	for (cpu_idx = EAS_CPU_PRV; cpu_idx < EAS_CPU_CNT; ++cpu_idx) {
+		int dst_cpu = eenv->cpu[cpu_idx].cpu_id;
+		bool dst_in = cpu_in_sg(sg_cl, dst_cpu);
+		unsigned long grp_util = max_util;
+		unsigned long cl_norm_util = 0;
+		int energy = 0;
+		int cap_idx, idle_idx;
+		unsigned long cap;
+
+		if (dst_cpu == -1)
+			continue;
+
+		if (dst_in) {
+			for (n = 0; n < nr; n++)
+				if (group_first_cpu(sgs[n]) == dst_cpu)
+					grp_util = max(grp_util,
+						util[n] + eenv->util_delta);
+		}
+
+		cap_idx = energy_lut_cap_idx(sg_cl->sge, cpu, grp_util);
+		cap = sg_cl->sge->cap_states[cap_idx].cap;
+		eenv->cpu[cpu_idx].cap_idx = cap_idx;
+		eenv->cpu[cpu_idx].cap = cap;
+
+		/* Per CPU groups */
+		for (n = 0; n < nr; n++) {
+			const struct sched_group_energy *sge = sgs[n]->sge;
+			int i = group_first_cpu(sgs[n]);
+			unsigned long u = util[n];
+			unsigned long norm_util;
+
+			if (i == dst_cpu)
+				u += eenv->util_delta;
+
+			norm_util = __cpu_norm_util(u, cap);
+			cl_norm_util += norm_util;
+
+			if ((i == src_cpu) != (i == dst_cpu))
+				idle_idx = group_idle_state_moved(sgs[n], u);
+			else
+				idle_idx = state[n] + 1;
+			idle_idx = min(idle_idx, (int)sge->nr_idle_states - 1);
+
+			energy += norm_util * sge->cap_states[cap_idx].power;
+			energy += (SCHED_CAPACITY_SCALE - norm_util) *
+				  sge->idle_states[idle_idx].power;
+		}
+
+		/* Frequency domain group */
+		cl_norm_util = min_t(unsigned long, cl_norm_util,
+				     SCHED_CAPACITY_SCALE);
+
+		if (cpu_in_sg(sg_cl, src_cpu) != dst_in)
+			idle_idx = group_idle_state_moved(sg_cl, sum_util +
+					(dst_in ? eenv->util_delta : 0));
+		else
+			idle_idx = cl_state + 1;
+		idle_idx = min(idle_idx, (int)sg_cl->sge->nr_idle_states - 1);
+
+		energy += cl_norm_util * sg_cl->sge->cap_states[cap_idx].power;
+		energy += (SCHED_CAPACITY_SCALE - cl_norm_util) *
+			  sg_cl->sge->idle_states[idle_idx].power;
+
+		eenv->cpu[cpu_idx].energy += energy;
+	}
+
+	return 0;
+}
+
 /*
  * select_energy_cpu_idx(): estimate the energy impact of changing the
  * utilization distribution.
@@ -6094,6 +6277,7 @@ static inline int select_energy_cpu_idx(struct energy_env *eenv)
 {
 	struct sched_domain *sd;
 	struct sched_group *sg;
+	bool use_lut;
 	int sd_cpu = -1;
 	int cpu_idx;
 	int margin;
@@ -6103,6 +6287,8 @@ static inline int select_energy_cpu_idx(struct energy_env *eenv)
 	if (!sd)
 		return EAS_CPU_PRV;
 
+	use_lut = sched_feat(EAS_ENERGY_LUT) && READ_ONCE(sched_energy_lut_valid);
+
 	cpumask_clear(&eenv->cpus_mask);
 	for (cpu_idx = EAS_CPU_PRV; cpu_idx < EAS_CPU_CNT; ++cpu_idx) {
 		int cpu = eenv->cpu[cpu_idx].cpu_id;
@@ -6120,6 +6306,9 @@ static inline int select_energy_cpu_idx(struct energy_env *eenv)
 
 		eenv->sg_top = sg;
 		/* energy is unscaled to reduce rounding errors */
+		if (use_lut &&
+		    compute_energy_lut(eenv, group_first_cpu(sg)) != -EAGAIN)
+			continue;
 		if (compute_energy(eenv) == -EINVAL)
 			return EAS_CPU_PRV;
 
@@ -6968,6 +7157,7 @@ static int cpu_util_wake(int cpu, struct task_struct *p)
 struct find_best_target_env {
 	struct cpumask *rtg_target;
 	bool need_idle;
+	bool latency_sensitive;
 	int placement_boost;
 	bool avoid_prev_cpu;
 };
@@ -7048,6 +7238,55 @@ static int start_cpu(struct task_struct *p, bool boosted,
 	return walt_start_cpu(start_cpu);
 }
 
+/*
+ * Try the CPUs recently picked as idle targets for p's schedtune group
+ * before scanning the sched domain. A cached CPU is only taken while it
+ * is still idle, in the cluster of @start (which already reflects boost
+ * and rtg_target), in its shallowest idle state, and passes the same
+ * checks the full scan applies to it.
+ */
+static int find_cached_target(struct task_struct *p, int start,
+			      unsigned long min_util,
+			      struct find_best_target_env *fbt_env)
+{
+	int cpus[SCHEDTUNE_PLACEMENT_SLOTS];
+	int nr, i;
+
+	nr = schedtune_placement_lookup(p, cpus);
+	for (i = 0; i < nr; i++) {
+		int cpu = cpus[i];
+		unsigned long new_util;
+
+		if (!cpumask_test_cpu(cpu, tsk_cpus_allowed(p)))
+			continue;
+
+		if (!cpu_online(cpu) || cpu_isolated(cpu) || !idle_cpu(cpu))
+			continue;
+
+		if (!same_cluster(cpu, start))
+			continue;
+
+		if (sysctl_sched_cstate_aware &&
+		    idle_get_state_idx(cpu_rq(cpu)) > 0)
+			continue;
+
+		if (walt_cpu_high_irqload(cpu) || is_reserved(cpu))
+			continue;
+
+		if (fbt_env->rtg_target &&
+		    !cpumask_test_cpu(cpu, fbt_env->rtg_target))
+			continue;
+
+		new_util = max(min_util, cpu_util_wake(cpu, p) + task_util(p));
+		if (cpu_check_overutil_condition(cpu, new_util))
+			continue;
+
+		return cpu;
+	}
+
+	return -1;
+}
+
 unsigned int sched_smp_overlap_capacity;
 static inline int find_best_target(struct task_struct *p, int *backup_cpu,
 				   bool boosted, bool prefer_idle,
@@ -7086,6 +7325,18 @@ static inline int find_best_target(struct task_struct *p, int *backup_cpu,
 		return -1;
 	}
 
+	/* Latency sensitive tasks: reuse a recent idle target if possible */
+	if (fbt_env->latency_sensitive && !fbt_env->placement_boost) {
+		target_cpu = find_cached_target(p, cpu, min_util, fbt_env);
+		schedtune_placement_stat(p, target_cpu != -1);
+		if (target_cpu != -1) {
+			trace_sched_find_best_target(p, prefer_idle, min_util,
+						     cpu, -1, -1,
+						     target_cpu, -1);
+			return target_cpu;
+		}
+	}
+
 	/* Find SD for the start CPU */
 	sd = rcu_dereference(per_cpu(sd_ea, cpu));
 	if (!sd) {
@@ -7198,6 +7449,9 @@ static inline int find_best_target(struct task_struct *p, int *backup_cpu,
 					schedstat_inc(p->se.statistics.nr_wakeups_fbt_pref_idle);
 					schedstat_inc(this_rq()->eas_stats.fbt_pref_idle);
 
+					if (fbt_env->latency_sensitive)
+						schedtune_placement_record(p, i);
+
 					trace_sched_find_best_target(p,
 							prefer_idle, min_util,
 							cpu, best_idle_cpu,
@@ -7433,6 +7687,10 @@ static inline int find_best_target(struct task_struct *p, int *backup_cpu,
 			target_cpu = isolated_candidate;
 	}
 
+	if (fbt_env->latency_sensitive && target_cpu != -1 &&
+	    idle_cpu(target_cpu))
+		schedtune_placement_record(p, target_cpu);
+
 	/*
 	 * - It is possible for target and backup
 	 *   to select same CPU - if so, drop backup
@@ -7594,6 +7852,7 @@ static int select_energy_cpu_brute(struct task_struct *p, int prev_cpu, int sync
 #endif
 
 	fbt_env.rtg_target = rtg_target;
+	fbt_env.latency_sensitive = prefer_idle;
 	if (sched_feat(EAS_USE_NEED_IDLE) && prefer_idle) {
 		fbt_env.need_idle = true;
 		prefer_idle = false;
@@ -9022,6 +9281,8 @@ static void update_cpu_capacity(struct sched_domain *sd, int cpu)
 	capacity >>= SCHED_CAPACITY_SHIFT;
 
 	capacity = min(capacity, thermal_cap(cpu));
+	if (cpu_rq(cpu)->cpu_capacity_orig != capacity)
+		schedtune_placement_invalidate();
 	cpu_rq(cpu)->cpu_capacity_orig = capacity;
 
 	mcc = &cpu_rq(cpu)->rd->max_cpu_capacity;
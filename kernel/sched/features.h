@@ -110,3 +110,9 @@ SCHED_FEAT(FBT_STRICT_ORDER, false)
  * OFF: schedtune.prefer_idle is honored as is.
  */
 SCHED_FEAT(EAS_USE_NEED_IDLE, true)
+/*
+ * Compute energy diffs for two level (CPU/frequency domain) energy models
+ * from the precomputed capacity lookup tables, without walking sched
+ * domains.
+ */
+SCHED_FEAT(EAS_ENERGY_LUT, true)
@@ -164,7 +164,7 @@ __setup("psi=", setup_psi);
 #define EXP_300s	2034		/* 1/exp(2s/300s) */
 
 /* PSI trigger definitions */
-#define WINDOW_MIN_US 500000	/* Min window size is 500ms */
+#define WINDOW_MIN_US 100000	/* Min window size is 100ms */
 #define WINDOW_MAX_US 10000000	/* Max window size is 10s */
 #define UPDATES_PER_WINDOW 10	/* 10 updates per window */
 
@@ -179,6 +179,16 @@ static struct psi_group psi_system = {
 
 static void psi_avgs_work(struct work_struct *work);
 
+/*
+ * All groups with triggers are polled from a single RT kworker, so
+ * that a per-cgroup monitor doesn't cost an RT thread per cgroup and
+ * polls of different groups due at the same time are handled in one
+ * wakeup. The worker lives as long as any group has triggers.
+ */
+static DEFINE_MUTEX(psi_poll_lock);
+static struct kthread_worker *psi_poll_kworker;
+static unsigned int psi_poll_users;
+
 static void group_init(struct psi_group *group)
 {
 	int cpu;
@@ -279,6 +289,40 @@ static void get_recent_times(struct psi_group *group, int cpu,
 	}
 }
 
+/**
+ * psi_cpu_some_time - cumulative CPU "some" stall time of a CPU
+ * @cpu: the CPU to sample
+ *
+ * Returns the time in ns that runnable tasks on @cpu spent waiting for it,
+ * including a stall that is still in progress. The value wraps at 32 bits
+ * and is only meaningful as a difference between two samples.
+ */
+u32 psi_cpu_some_time(int cpu)
+{
+	struct psi_group_cpu *groupc;
+	u64 now, state_start;
+	unsigned int seq;
+	u32 state_mask;
+	u32 time;
+
+	if (static_branch_likely(&psi_disabled))
+		return 0;
+
+	groupc = per_cpu_ptr(psi_system.pcpu, cpu);
+	do {
+		seq = read_seqcount_begin(&groupc->seq);
+		now = cpu_clock(cpu);
+		time = groupc->times[PSI_CPU_SOME];
+		state_mask = groupc->state_mask;
+		state_start = groupc->state_start;
+	} while (read_seqcount_retry(&groupc->seq, seq));
+
+	if (state_mask & (1 << PSI_CPU_SOME))
+		time += now - state_start;
+
+	return time;
+}
+
 static void calc_avgs(unsigned long avg[3], int missed_periods,
 		      u64 time, u64 period)
 {
@@ -616,6 +660,17 @@ static void psi_poll_work(struct kthread_work *work)
 	if (now >= group->polling_next_update)
 		group->polling_next_update = update_triggers(group, now);
 
+	/*
+	 * No monitored state accumulated any time since the last poll,
+	 * so none of them is active and the trigger windows have nothing
+	 * to add. Don't re-arm the timer; psi_task_change() queues us
+	 * again as soon as a task puts the group in a monitored state.
+	 * polling_until is left alone so the windows carry on instead of
+	 * being reset if that happens within the current polling period.
+	 */
+	if (!(changed_states & group->poll_states))
+		goto out;
+
 	psi_schedule_poll_work(group,
 		nsecs_to_jiffies(group->polling_next_update - now) + 1);
 
@@ -1004,6 +1059,44 @@ static int psi_cpu_open(struct inode *inode, struct file *file)
 	return single_open(file, psi_cpu_show, NULL);
 }
 
+static struct kthread_worker *psi_poll_worker_get(void)
+{
+	struct kthread_worker *kworker;
+
+	mutex_lock(&psi_poll_lock);
+	if (!psi_poll_kworker) {
+		struct sched_param param = {
+			.sched_priority = 1,
+		};
+
+		kworker = kthread_create_worker(0, "psimon");
+		if (IS_ERR(kworker))
+			goto out;
+		sched_setscheduler_nocheck(kworker->task, SCHED_FIFO, &param);
+		psi_poll_kworker = kworker;
+	}
+	psi_poll_users++;
+	kworker = psi_poll_kworker;
+out:
+	mutex_unlock(&psi_poll_lock);
+	return kworker;
+}
+
+static void psi_poll_worker_put(void)
+{
+	struct kthread_worker *kworker = NULL;
+
+	mutex_lock(&psi_poll_lock);
+	if (!--psi_poll_users) {
+		kworker = psi_poll_kworker;
+		psi_poll_kworker = NULL;
+	}
+	mutex_unlock(&psi_poll_lock);
+
+	if (kworker)
+		kthread_destroy_worker(kworker);
+}
+
 struct psi_trigger *psi_trigger_create(struct psi_group *group,
 			char *buf, size_t nbytes, enum psi_res res)
 {
@@ -1051,18 +1144,14 @@ struct psi_trigger *psi_trigger_create(struct psi_group *group,
 	mutex_lock(&group->trigger_lock);
 
 	if (!rcu_access_pointer(group->poll_kworker)) {
-		struct sched_param param = {
-			.sched_priority = 1,
-		};
 		struct kthread_worker *kworker;
 
-		kworker = kthread_create_worker(0, "psimon");
+		kworker = psi_poll_worker_get();
 		if (IS_ERR(kworker)) {
 			kfree(t);
 			mutex_unlock(&group->trigger_lock);
 			return ERR_CAST(kworker);
 		}
-		sched_setscheduler_nocheck(kworker->task, SCHED_FIFO, &param);
 		kthread_init_delayed_work(&group->poll_work,
 				psi_poll_work);
 		rcu_assign_pointer(group->poll_kworker, kworker);
@@ -1109,7 +1198,7 @@ static void psi_trigger_destroy(struct kref *ref)
 			period = min(period, div_u64(tmp->win.size,
 					UPDATES_PER_WINDOW));
 		group->poll_min_period = period;
-		/* Destroy poll_kworker when the last trigger is destroyed */
+		/* Detach from poll_kworker when the last trigger is destroyed */
 		if (group->poll_states == 0) {
 			group->polling_until = 0;
 			kworker_to_destroy = rcu_dereference_protected(
@@ -1141,7 +1230,7 @@ static void psi_trigger_destroy(struct kref *ref)
 		kthread_cancel_delayed_work_sync(&group->poll_work);
 		atomic_set(&group->poll_scheduled, 0);
 
-		kthread_destroy_worker(kworker_to_destroy);
+		psi_poll_worker_put();
 	}
 	kfree(t);
 }
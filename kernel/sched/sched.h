@@ -830,6 +830,7 @@ struct rq {
 	struct load_subtractions load_subs[NUM_TRACKED_WINDOWS];
 	DECLARE_BITMAP_ARRAY(top_tasks_bitmap,
 			NUM_TRACKED_WINDOWS, NUM_LOAD_INDICES);
+	unsigned long top_tasks_summary[NUM_TRACKED_WINDOWS];
 	u8 *top_tasks[NUM_TRACKED_WINDOWS];
 	u8 curr_table;
 	int prev_top;
@@ -2426,6 +2427,7 @@ struct related_thread_group {
 	struct sched_cluster *preferred_cluster;
 	struct rcu_head rcu;
 	u64 last_update;
+	unsigned int predictor;
 };
 
 extern struct list_head cluster_head;
@@ -2707,7 +2709,6 @@ extern int preferred_cluster(struct sched_cluster *cluster,
 						struct task_struct *p);
 extern struct sched_cluster *rq_cluster(struct rq *rq);
 extern void reset_task_stats(struct task_struct *p);
-extern void clear_top_tasks_bitmap(unsigned long *bitmap);
 
 #if defined(CONFIG_SCHED_TUNE) && defined(CONFIG_CGROUP_SCHEDTUNE)
 extern bool task_sched_boost(struct task_struct *p);
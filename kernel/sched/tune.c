@@ -217,6 +217,15 @@ struct schedtune {
 	/* Hint to bias scheduling of tasks on that SchedTune CGroup
 	 * towards idle CPUs */
 	int prefer_idle;
+
+	/*
+	 * Most recently used idle targets of latency sensitive wakeups,
+	 * valid only while gen matches schedtune_placement_gen.
+	 */
+	struct {
+		int cpu[SCHEDTUNE_PLACEMENT_SLOTS];
+		unsigned int gen;
+	} placement;
 };
 
 static inline struct schedtune *css_st(struct cgroup_subsys_state *css)
@@ -778,6 +787,177 @@ int schedtune_prefer_idle(struct task_struct *p)
 	return prefer_idle;
 }
 
+/*
+ * Placement cache
+ *
+ * find_best_target() scans every candidate CPU on each wakeup, which for
+ * prefer_idle groups under load is a lot of work just to find that the
+ * idle CPU picked last time is still idle. Each group remembers the last
+ * few idle CPUs picked for its tasks so that the wakeup path can try them
+ * first. Entries are not trusted: the caller revalidates idleness and fit
+ * on every lookup, so a CPU leaving idle simply misses and gets replaced.
+ * Capacity changes bump schedtune_placement_gen, dropping every entry.
+ * The generation starts at 1 so that a zeroed group starts out empty.
+ */
+static atomic_t schedtune_placement_gen = ATOMIC_INIT(1);
+
+int schedtune_placement_lookup(struct task_struct *p, int *cpus)
+{
+	struct schedtune *st;
+	int nr = 0;
+	int slot;
+
+	if (!unlikely(schedtune_initialized))
+		return 0;
+
+	rcu_read_lock();
+	st = task_schedtune(p);
+	if (READ_ONCE(st->placement.gen) ==
+			atomic_read(&schedtune_placement_gen)) {
+		for (slot = 0; slot < SCHEDTUNE_PLACEMENT_SLOTS; slot++) {
+			int cpu = READ_ONCE(st->placement.cpu[slot]);
+
+			if (cpu >= 0)
+				cpus[nr++] = cpu;
+		}
+	}
+	rcu_read_unlock();
+
+	return nr;
+}
+
+void schedtune_placement_record(struct task_struct *p, int cpu)
+{
+	unsigned int gen = atomic_read(&schedtune_placement_gen);
+	struct schedtune *st;
+	int slot;
+
+	if (!unlikely(schedtune_initialized))
+		return;
+
+	rcu_read_lock();
+	st = task_schedtune(p);
+
+	if (READ_ONCE(st->placement.gen) != gen) {
+		for (slot = 0; slot < SCHEDTUNE_PLACEMENT_SLOTS; slot++)
+			WRITE_ONCE(st->placement.cpu[slot], -1);
+		WRITE_ONCE(st->placement.gen, gen);
+	}
+
+	/* Move @cpu to the front, evicting the least recently used entry */
+	for (slot = 0; slot < SCHEDTUNE_PLACEMENT_SLOTS - 1; slot++)
+		if (READ_ONCE(st->placement.cpu[slot]) == cpu)
+			break;
+	for (; slot > 0; slot--)
+		WRITE_ONCE(st->placement.cpu[slot],
+			   READ_ONCE(st->placement.cpu[slot - 1]));
+	WRITE_ONCE(st->placement.cpu[0], cpu);
+
+	rcu_read_unlock();
+}
+
+void schedtune_placement_invalidate(void)
+{
+	/* Never hand out generation 0, see above */
+	if (unlikely(atomic_inc_return(&schedtune_placement_gen) == 0))
+		atomic_inc(&schedtune_placement_gen);
+}
+
+#ifdef CONFIG_SCHEDSTATS
+/*
+ * Per boost group wakeup statistics. Updates always come from the CPU
+ * they are accounted to with interrupts disabled, so plain per-CPU
+ * counters are enough.
+ */
+struct schedtune_stats {
+	u64 placement_hits;
+	u64 placement_misses;
+	u64 wakeup_count;
+	u64 wakeup_lat_sum;
+	u64 wakeup_lat_max;
+};
+
+static DEFINE_PER_CPU(struct schedtune_stats [BOOSTGROUPS_COUNT],
+		      schedtune_stats);
+
+static inline struct schedtune_stats *this_cpu_st_stats(struct task_struct *p)
+{
+	struct schedtune_stats *stats;
+
+	rcu_read_lock();
+	stats = &this_cpu_ptr(schedtune_stats)[task_schedtune(p)->idx];
+	rcu_read_unlock();
+
+	return stats;
+}
+
+void schedtune_placement_stat(struct task_struct *p, bool hit)
+{
+	struct schedtune_stats *stats;
+
+	if (!unlikely(schedtune_initialized) || !schedstat_enabled())
+		return;
+
+	stats = this_cpu_st_stats(p);
+	if (hit)
+		stats->placement_hits++;
+	else
+		stats->placement_misses++;
+}
+
+void schedtune_wakeup_latency(struct task_struct *p, u64 delta)
+{
+	struct schedtune_stats *stats;
+
+	if (!unlikely(schedtune_initialized))
+		return;
+
+	stats = this_cpu_st_stats(p);
+	stats->wakeup_count++;
+	stats->wakeup_lat_sum += delta;
+	stats->wakeup_lat_max = max(stats->wakeup_lat_max, delta);
+}
+
+static int
+placement_stats_show(struct seq_file *sf, void *v)
+{
+	struct schedtune *st = css_st(seq_css(sf));
+	struct schedtune_stats sum = { 0, };
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct schedtune_stats *stats;
+
+		stats = &per_cpu(schedtune_stats, cpu)[st->idx];
+		sum.placement_hits += stats->placement_hits;
+		sum.placement_misses += stats->placement_misses;
+		sum.wakeup_count += stats->wakeup_count;
+		sum.wakeup_lat_sum += stats->wakeup_lat_sum;
+		sum.wakeup_lat_max = max(sum.wakeup_lat_max,
+					 stats->wakeup_lat_max);
+	}
+
+	seq_printf(sf, "placement_hits %llu\n", sum.placement_hits);
+	seq_printf(sf, "placement_misses %llu\n", sum.placement_misses);
+	seq_printf(sf, "wakeup_count %llu\n", sum.wakeup_count);
+	seq_printf(sf, "wakeup_lat_sum_ns %llu\n", sum.wakeup_lat_sum);
+	seq_printf(sf, "wakeup_lat_max_ns %llu\n", sum.wakeup_lat_max);
+
+	return 0;
+}
+
+static void schedtune_stats_reset(int idx)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(&per_cpu(schedtune_stats, cpu)[idx], 0,
+		       sizeof(struct schedtune_stats));
+}
+#else
+static inline void schedtune_stats_reset(int idx) { }
+#endif /* CONFIG_SCHEDSTATS */
+
 static u64
 prefer_idle_read(struct cgroup_subsys_state *css, struct cftype *cft)
 {
@@ -892,6 +1072,12 @@ static struct cftype files[] = {
 		.read_u64 = prefer_idle_read,
 		.write_u64 = prefer_idle_write,
 	},
+#ifdef CONFIG_SCHEDSTATS
+	{
+		.name = "placement_stats",
+		.seq_show = placement_stats_show,
+	},
+#endif
 	{ }	/* terminate */
 };
 
@@ -907,6 +1093,7 @@ schedtune_boostgroup_init(struct schedtune *st, int idx)
 		bg->group[idx].boost = 0;
 		bg->group[idx].valid = true;
 	}
+	schedtune_stats_reset(idx);
 
 	/* Keep track of allocated boost groups */
 	allocated_group[idx] = st;
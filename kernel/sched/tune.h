@@ -1,4 +1,7 @@
 
+/* CPUs remembered per boost group as recent idle wakeup targets */
+#define SCHEDTUNE_PLACEMENT_SLOTS 2
+
 #ifdef CONFIG_SCHED_TUNE
 
 #include <linux/reciprocal_div.h>
@@ -24,6 +27,18 @@ void schedtune_exit_task(struct task_struct *tsk);
 void schedtune_enqueue_task(struct task_struct *p, int cpu);
 void schedtune_dequeue_task(struct task_struct *p, int cpu);
 
+int schedtune_placement_lookup(struct task_struct *p, int *cpus);
+void schedtune_placement_record(struct task_struct *p, int cpu);
+void schedtune_placement_invalidate(void);
+
+#ifdef CONFIG_SCHEDSTATS
+void schedtune_placement_stat(struct task_struct *p, bool hit);
+void schedtune_wakeup_latency(struct task_struct *p, u64 delta);
+#else
+#define schedtune_placement_stat(tsk, hit) do { } while (0)
+#define schedtune_wakeup_latency(tsk, delta) do { } while (0)
+#endif
+
 #else /* CONFIG_CGROUP_SCHEDTUNE */
 
 #define schedtune_cpu_boost(cpu)  get_sysctl_sched_cfs_boost()
@@ -35,6 +50,12 @@ void schedtune_dequeue_task(struct task_struct *p, int cpu);
 #define schedtune_enqueue_task(task, cpu) do { } while (0)
 #define schedtune_dequeue_task(task, cpu) do { } while (0)
 
+#define schedtune_placement_lookup(tsk, cpus) 0
+#define schedtune_placement_record(tsk, cpu) do { } while (0)
+#define schedtune_placement_invalidate() do { } while (0)
+#define schedtune_placement_stat(tsk, hit) do { } while (0)
+#define schedtune_wakeup_latency(tsk, delta) do { } while (0)
+
 #endif /* CONFIG_CGROUP_SCHEDTUNE */
 
 int schedtune_normalize_energy(int energy);
@@ -52,6 +73,12 @@ int schedtune_accept_deltas(int nrg_delta, int cap_delta,
 #define schedtune_enqueue_task(task, cpu) do { } while (0)
 #define schedtune_dequeue_task(task, cpu) do { } while (0)
 
+#define schedtune_placement_lookup(tsk, cpus) 0
+#define schedtune_placement_record(tsk, cpu) do { } while (0)
+#define schedtune_placement_invalidate() do { } while (0)
+#define schedtune_placement_stat(tsk, hit) do { } while (0)
+#define schedtune_wakeup_latency(tsk, delta) do { } while (0)
+
 #define schedtune_accept_deltas(nrg_delta, cap_delta, task) nrg_delta
 
 #endif /* CONFIG_SCHED_TUNE */
@@ -209,9 +209,15 @@ unsigned int __read_mostly sched_disable_window_stats;
  */
 __read_mostly unsigned int sched_load_granule =
 			MIN_SCHED_RAVG_WINDOW / NUM_LOAD_INDICES;
-/* Size of bitmaps maintained to track top tasks */
+/*
+ * Size of bitmaps maintained to track top tasks. Bucket 'index' is bit
+ * (NUM_LOAD_INDICES - 1 - index), so the lowest set bit is the heaviest
+ * occupied bucket. rq->top_tasks_summary[] has bit 'w' set whenever word
+ * 'w' of the matching bitmap is non-zero, which turns the top lookup into
+ * two __ffs() calls.
+ */
 static const unsigned int top_tasks_bitmap_size =
-		BITS_TO_LONGS(NUM_LOAD_INDICES + 1) * sizeof(unsigned long);
+		BITS_TO_LONGS(NUM_LOAD_INDICES) * sizeof(unsigned long);
 
 /*
  * This governs what load needs to be used when reporting CPU busy time
@@ -620,7 +626,71 @@ static inline void create_subtraction_entry(struct rq *rq, u64 ws, int index)
 	rq->load_subs[index].new_subs = 0;
 }
 
-static int get_top_index(unsigned long *bitmap, unsigned long old_top)
+static inline void __top_tasks_set_bit(unsigned long *bitmap,
+				       unsigned long *summary, int index)
+{
+	int bit = NUM_LOAD_INDICES - index - 1;
+
+	__set_bit(bit, bitmap);
+	__set_bit(BIT_WORD(bit), summary);
+}
+
+static inline void __top_tasks_clear_bit(unsigned long *bitmap,
+					 unsigned long *summary, int index)
+{
+	int bit = NUM_LOAD_INDICES - index - 1;
+
+	__clear_bit(bit, bitmap);
+	if (!bitmap[BIT_WORD(bit)])
+		__clear_bit(BIT_WORD(bit), summary);
+}
+
+static int __get_top_index(unsigned long *bitmap, unsigned long summary)
+{
+	int word;
+
+	if (!summary)
+		return 0;
+
+	word = __ffs(summary);
+
+	return NUM_LOAD_INDICES - 1 - (word * BITS_PER_LONG +
+			__ffs(bitmap[word]));
+}
+
+static inline void top_tasks_set_bit(struct rq *rq, u8 table, int index)
+{
+	__top_tasks_set_bit(rq->top_tasks_bitmap[table],
+			    &rq->top_tasks_summary[table], index);
+}
+
+static inline void top_tasks_clear_bit(struct rq *rq, u8 table, int index)
+{
+	__top_tasks_clear_bit(rq->top_tasks_bitmap[table],
+			      &rq->top_tasks_summary[table], index);
+}
+
+static int get_top_index(struct rq *rq, u8 table)
+{
+	return __get_top_index(rq->top_tasks_bitmap[table],
+			       rq->top_tasks_summary[table]);
+}
+
+#ifdef CONFIG_SCHED_DEBUG
+/*
+ * Boot-time check of get_top_index() against the find_next_bit() search
+ * it replaced, run on the pattern migrate_top_tasks() produces: the top
+ * bucket has just emptied and a lower one is still occupied.
+ *
+ * The old search started at bit 'old_top' rather than at the old top's
+ * bit position, NUM_LOAD_INDICES - 1 - old_top. Below half the window
+ * that start is at or before the old top's bit and both lookups agree.
+ * From half the window up it is past it, so the old search skipped the
+ * buckets between the two positions and could report a lower top than
+ * the highest occupied bucket, or none at all. That case is checked
+ * against the highest occupied bucket instead.
+ */
+static int old_get_top_index(unsigned long *bitmap, unsigned long old_top)
 {
 	int index = find_next_bit(bitmap, NUM_LOAD_INDICES, old_top);
 
@@ -630,6 +700,42 @@ static int get_top_index(unsigned long *bitmap, unsigned long old_top)
 	return NUM_LOAD_INDICES - 1 - index;
 }
 
+static int __init walt_top_index_selftest(void)
+{
+	DECLARE_BITMAP(bitmap, NUM_LOAD_INDICES);
+	unsigned long summary;
+	int top, i, failed = 0;
+
+	for (top = 1; top < NUM_LOAD_INDICES; top++) {
+		int lower[] = { 0, top / 2, top - 1 };
+
+		for (i = 0; i < ARRAY_SIZE(lower); i++) {
+			int new;
+
+			bitmap_zero(bitmap, NUM_LOAD_INDICES);
+			summary = 0;
+			__top_tasks_set_bit(bitmap, &summary, lower[i]);
+			__top_tasks_set_bit(bitmap, &summary, top);
+			__top_tasks_clear_bit(bitmap, &summary, top);
+
+			new = __get_top_index(bitmap, summary);
+			if (new != lower[i] ||
+			    (top < NUM_LOAD_INDICES / 2 &&
+			     old_get_top_index(bitmap, top) != new)) {
+				pr_err("walt: top index mismatch: top=%d lower=%d new=%d old=%d\n",
+				       top, lower[i], new,
+				       old_get_top_index(bitmap, top));
+				failed++;
+			}
+		}
+	}
+
+	WARN_ON(failed);
+	return 0;
+}
+late_initcall(walt_top_index_selftest);
+#endif
+
 static bool get_subtraction_index(struct rq *rq, u64 ws)
 {
 	int i;
@@ -760,20 +866,17 @@ migrate_top_tasks(struct task_struct *p, struct rq *src_rq, struct rq *dst_rq)
 		dst_table[index] += 1;
 
 		if (!src_table[index])
-			__clear_bit(NUM_LOAD_INDICES - index - 1,
-				src_rq->top_tasks_bitmap[src]);
+			top_tasks_clear_bit(src_rq, src, index);
 
 		if (dst_table[index] == 1)
-			__set_bit(NUM_LOAD_INDICES - index - 1,
-				dst_rq->top_tasks_bitmap[dst]);
+			top_tasks_set_bit(dst_rq, dst, index);
 
 		if (index > dst_rq->curr_top)
 			dst_rq->curr_top = index;
 
 		top_index = src_rq->curr_top;
 		if (index == top_index && !src_table[index])
-			src_rq->curr_top = get_top_index(
-				src_rq->top_tasks_bitmap[src], top_index);
+			src_rq->curr_top = get_top_index(src_rq, src);
 	}
 
 	if (prev_window) {
@@ -786,20 +889,17 @@ migrate_top_tasks(struct task_struct *p, struct rq *src_rq, struct rq *dst_rq)
 		dst_table[index] += 1;
 
 		if (!src_table[index])
-			__clear_bit(NUM_LOAD_INDICES - index - 1,
-				src_rq->top_tasks_bitmap[src]);
+			top_tasks_clear_bit(src_rq, src, index);
 
 		if (dst_table[index] == 1)
-			__set_bit(NUM_LOAD_INDICES - index - 1,
-				dst_rq->top_tasks_bitmap[dst]);
+			top_tasks_set_bit(dst_rq, dst, index);
 
 		if (index > dst_rq->prev_top)
 			dst_rq->prev_top = index;
 
 		top_index = src_rq->prev_top;
 		if (index == top_index && !src_table[index])
-			src_rq->prev_top = get_top_index(
-				src_rq->top_tasks_bitmap[src], top_index);
+			src_rq->prev_top = get_top_index(src_rq, src);
 	}
 }
 
@@ -1089,13 +1189,121 @@ static u32 get_pred_busy(struct rq *rq, struct task_struct *p,
 	return ret;
 }
 
+/*
+ * Wakeup cadence tracking. The interval between wakeups is folded into
+ * a running average with weight 1/2^WAKE_PERIOD_SHIFT, as is its absolute
+ * deviation from that average. A sleep longer than two windows breaks the
+ * cadence and starts the averages over.
+ */
+#define WAKE_PERIOD_SHIFT	3
+#define WAKE_JITTER_PCT		12
+
+static void update_wake_period(struct task_struct *p, u64 interval)
+{
+	struct ravg *ravg = &p->ravg;
+	s64 delta;
+
+	if (interval > 2 * (u64)sched_ravg_window) {
+		ravg->wake_period = 0;
+		ravg->wake_jitter = 0;
+		return;
+	}
+
+	/* Start out fully jittered so a cadence has to be earned */
+	if (!ravg->wake_period) {
+		ravg->wake_period = interval;
+		ravg->wake_jitter = interval;
+		return;
+	}
+
+	delta = (s64)interval - ravg->wake_period;
+	ravg->wake_period += delta >> WAKE_PERIOD_SHIFT;
+	ravg->wake_jitter += ((s64)abs(delta) - ravg->wake_jitter) >>
+							WAKE_PERIOD_SHIFT;
+}
+
+static inline bool task_wakes_periodically(struct task_struct *p)
+{
+	u32 period = p->ravg.wake_period;
+
+	return period && (u64)p->ravg.wake_jitter * 100 <=
+				(u64)period * WAKE_JITTER_PCT;
+}
+
+/*
+ * get_pred_busy_periodic - prediction for tasks with a steady wakeup cadence
+ *
+ * When the cadence does not divide the window, a periodic task's busy time
+ * beats between windows holding a different number of period starts. The
+ * bucket predictor settles on the lighter windows and under-shoots at the
+ * start of the heavier ones, so predict the envelope of the recent history
+ * instead. Tasks without a stable cadence fall back to get_pred_busy().
+ */
+static u32 get_pred_busy_periodic(struct rq *rq, struct task_struct *p,
+				  int start, u32 runtime)
+{
+	u32 *hist = p->ravg.sum_history;
+	u32 ret = runtime;
+	int i;
+
+	if (unlikely(is_new_task(p)) || !task_wakes_periodically(p))
+		return get_pred_busy(rq, p, start, runtime);
+
+	for (i = 0; i < sched_ravg_hist_size; i++)
+		ret = max(ret, hist[i]);
+
+	trace_sched_update_pred_demand(rq, p, runtime, 0, ret);
+	return ret;
+}
+
+/*
+ * Demand predictors, selected per related_thread_group through
+ * sched_set_group_predictor(). Tasks outside a group use the bucket
+ * predictor. The busy buckets are updated whichever predictor is in use,
+ * so switching back does not start from an empty history.
+ */
+struct walt_predictor {
+	const char *name;
+	u32 (*predict)(struct rq *rq, struct task_struct *p,
+		       int start, u32 runtime);
+};
+
+enum {
+	WALT_PRED_BUCKETS,
+	WALT_PRED_PERIODIC,
+	WALT_PRED_NR,
+};
+
+static const struct walt_predictor walt_predictors[WALT_PRED_NR] = {
+	[WALT_PRED_BUCKETS] = {
+		.name = "buckets",
+		.predict = get_pred_busy,
+	},
+	[WALT_PRED_PERIODIC] = {
+		.name = "periodic",
+		.predict = get_pred_busy_periodic,
+	},
+};
+
+static inline const struct walt_predictor *
+task_predictor(struct task_struct *p)
+{
+	struct related_thread_group *grp = p->grp;
+
+	if (!grp)
+		return &walt_predictors[WALT_PRED_BUCKETS];
+
+	return &walt_predictors[READ_ONCE(grp->predictor)];
+}
+
 static inline u32 calc_pred_demand(struct rq *rq, struct task_struct *p)
 {
 	if (p->ravg.pred_demand >= p->ravg.curr_window)
 		return p->ravg.pred_demand;
 
-	return get_pred_busy(rq, p, busy_to_bucket(p->ravg.curr_window),
-			     p->ravg.curr_window);
+	return task_predictor(p)->predict(rq, p,
+			busy_to_bucket(p->ravg.curr_window),
+			p->ravg.curr_window);
 }
 
 /*
@@ -1143,10 +1351,10 @@ void update_task_pred_demand(struct rq *rq, struct task_struct *p, int event)
 	p->ravg.pred_demand = new;
 }
 
-void clear_top_tasks_bitmap(unsigned long *bitmap)
+static void clear_top_tasks_bitmap(struct rq *rq, u8 table)
 {
-	memset(bitmap, 0, top_tasks_bitmap_size);
-	__set_bit(NUM_LOAD_INDICES, bitmap);
+	memset(rq->top_tasks_bitmap[table], 0, top_tasks_bitmap_size);
+	rq->top_tasks_summary[table] = 0;
 }
 
 static void update_top_tasks(struct task_struct *p, struct rq *rq,
@@ -1179,12 +1387,10 @@ static void update_top_tasks(struct task_struct *p, struct rq *rq,
 		}
 
 		if (!curr_table[old_index])
-			__clear_bit(NUM_LOAD_INDICES - old_index - 1,
-				rq->top_tasks_bitmap[curr]);
+			top_tasks_clear_bit(rq, curr, old_index);
 
 		if (curr_table[new_index] == 1)
-			__set_bit(NUM_LOAD_INDICES - new_index - 1,
-				rq->top_tasks_bitmap[curr]);
+			top_tasks_set_bit(rq, curr, new_index);
 
 		return;
 	}
@@ -1211,8 +1417,7 @@ static void update_top_tasks(struct task_struct *p, struct rq *rq,
 		}
 
 		if (prev_table[update_index] == 1)
-			__set_bit(NUM_LOAD_INDICES - update_index - 1,
-				rq->top_tasks_bitmap[prev]);
+			top_tasks_set_bit(rq, prev, update_index);
 	} else {
 		zero_index_update = !old_curr_window && prev_window;
 		if (old_index != update_index || zero_index_update) {
@@ -1225,12 +1430,10 @@ static void update_top_tasks(struct task_struct *p, struct rq *rq,
 				rq->prev_top = update_index;
 
 			if (!prev_table[old_index])
-				__clear_bit(NUM_LOAD_INDICES - old_index - 1,
-						rq->top_tasks_bitmap[prev]);
+				top_tasks_clear_bit(rq, prev, old_index);
 
 			if (prev_table[update_index] == 1)
-				__set_bit(NUM_LOAD_INDICES - update_index - 1,
-						rq->top_tasks_bitmap[prev]);
+				top_tasks_set_bit(rq, prev, update_index);
 		}
 	}
 
@@ -1241,8 +1444,7 @@ static void update_top_tasks(struct task_struct *p, struct rq *rq,
 			rq->curr_top = new_index;
 
 		if (curr_table[new_index] == 1)
-			__set_bit(NUM_LOAD_INDICES - new_index - 1,
-				rq->top_tasks_bitmap[curr]);
+			top_tasks_set_bit(rq, curr, new_index);
 	}
 }
 
@@ -1253,13 +1455,12 @@ static void rollover_top_tasks(struct rq *rq, bool full_window)
 	int curr_top = rq->curr_top;
 
 	clear_top_tasks_table(rq->top_tasks[prev_table]);
-	clear_top_tasks_bitmap(rq->top_tasks_bitmap[prev_table]);
+	clear_top_tasks_bitmap(rq, prev_table);
 
 	if (full_window) {
 		curr_top = 0;
 		clear_top_tasks_table(rq->top_tasks[curr_table]);
-		clear_top_tasks_bitmap(
-				rq->top_tasks_bitmap[curr_table]);
+		clear_top_tasks_bitmap(rq, curr_table);
 	}
 
 	rq->curr_table = prev_table;
@@ -1663,7 +1864,7 @@ static inline u32 predict_and_update_buckets(struct rq *rq,
 		return 0;
 
 	bidx = busy_to_bucket(runtime);
-	pred_demand = get_pred_busy(rq, p, bidx, runtime);
+	pred_demand = task_predictor(p)->predict(rq, p, bidx, runtime);
 	bucket_increase(p->ravg.busy_buckets, bidx);
 
 	return pred_demand;
@@ -2816,12 +3017,14 @@ static void remove_task_from_group(struct task_struct *p)
 	raw_spin_unlock(&grp->lock);
 
 	/* Reserved groups cannot be destroyed */
-	if (empty_group && grp->id != DEFAULT_CGROUP_COLOC_ID)
+	if (empty_group && grp->id != DEFAULT_CGROUP_COLOC_ID) {
 		 /*
 		  * We test whether grp->list is attached with list_empty()
 		  * hence re-init the list after deletion.
 		  */
 		list_del_init(&grp->list);
+		WRITE_ONCE(grp->predictor, WALT_PRED_BUCKETS);
+	}
 }
 
 static int
@@ -2951,6 +3154,42 @@ unsigned int sched_get_group_id(struct task_struct *p)
 	return group_id;
 }
 
+/*
+ * Select the demand predictor for the related thread group @p belongs to.
+ * The choice sticks to the group until its last task leaves.
+ */
+int sched_set_group_predictor(struct task_struct *p, unsigned int predictor)
+{
+	struct related_thread_group *grp;
+	int rc = -EINVAL;
+
+	if (predictor >= WALT_PRED_NR)
+		return -EINVAL;
+
+	rcu_read_lock();
+	grp = task_related_thread_group(p);
+	if (grp) {
+		WRITE_ONCE(grp->predictor, predictor);
+		rc = 0;
+	}
+	rcu_read_unlock();
+
+	return rc;
+}
+
+int sched_get_group_predictor(struct task_struct *p)
+{
+	struct related_thread_group *grp;
+	int predictor;
+
+	rcu_read_lock();
+	grp = task_related_thread_group(p);
+	predictor = grp ? READ_ONCE(grp->predictor) : -1;
+	rcu_read_unlock();
+
+	return predictor;
+}
+
 #if defined(CONFIG_SCHED_TUNE) && defined(CONFIG_CGROUP_SCHEDTUNE)
 /*
  * We create a default colocation group at boot. There is no need to
@@ -3074,6 +3313,7 @@ void sched_update_cpu_freq_min_max(const cpumask_t *cpus, u32 fmin, u32 fmax)
 
 void note_task_waking(struct task_struct *p, u64 wallclock)
 {
+	update_wake_period(p, wallclock - p->last_wake_ts);
 	p->last_wake_ts = wallclock;
 }
 
@@ -3261,14 +3501,19 @@ void walt_irq_work(struct irq_work *irq_work)
 	struct rq *rq;
 	int cpu;
 	u64 wc, total_grp_load = 0;
+	u64 t_start = 0, t_locked = 0;
 	int flag = SCHED_CPUFREQ_WALT;
 	bool is_migration = false;
+	bool timed = trace_sched_walt_irq_work_enabled();
 	int level = 0;
 
 	/* Am I the window rollover work or the migration work? */
 	if (irq_work == &walt_migration_irq_work)
 		is_migration = true;
 
+	if (timed)
+		t_start = sched_ktime_clock();
+
 	for_each_cpu(cpu, cpu_possible_mask) {
 		if (level == 0)
 			raw_spin_lock(&cpu_rq(cpu)->lock);
@@ -3278,6 +3523,7 @@ void walt_irq_work(struct irq_work *irq_work)
 	}
 
 	wc = sched_ktime_clock();
+	t_locked = wc;
 	walt_load_reported_window = atomic64_read(&walt_irq_work_lastq_ws);
 
 	for_each_sched_cluster(cluster) {
@@ -3324,9 +3570,18 @@ void walt_irq_work(struct irq_work *irq_work)
 		}
 	}
 
+	if (timed)
+		t_locked = sched_ktime_clock() - t_locked;
+
 	for_each_cpu(cpu, cpu_possible_mask)
 		raw_spin_unlock(&cpu_rq(cpu)->lock);
 
+	if (timed)
+		trace_sched_walt_irq_work(is_migration,
+					  walt_load_reported_window,
+					  sched_ktime_clock() - t_start,
+					  t_locked);
+
 	if (!is_migration)
 		core_ctl_check(this_rq()->window_start);
 }
@@ -3376,6 +3631,9 @@ void walt_sched_init(struct rq *rq)
 {
 	int j;
 
+	/* The summary word must cover every word of a top task bitmap */
+	BUILD_BUG_ON(BITS_TO_LONGS(NUM_LOAD_INDICES) > BITS_PER_LONG);
+
 	cpumask_set_cpu(cpu_of(rq), &rq->freq_domain_cpumask);
 	init_irq_work(&walt_migration_irq_work, walt_irq_work);
 	init_irq_work(&walt_cpufreq_irq_work, walt_irq_work);
@@ -3422,7 +3680,7 @@ void walt_sched_init(struct rq *rq)
 				sizeof(u8), GFP_NOWAIT);
 		/* No other choice */
 		BUG_ON(!rq->top_tasks[j]);
-		clear_top_tasks_bitmap(rq->top_tasks_bitmap[j]);
+		clear_top_tasks_bitmap(rq, j);
 	}
 	rq->cum_window_demand = 0;
 	rq->notif_pending = false;
@@ -223,6 +223,28 @@ static int PageHugeObject(struct page *page)
 	return PageOwnerPriv1(page);
 }
 
+/*
+ * Number of objects kept in each per-cpu magazine. This keeps a magazine
+ * at 64 bytes on 64bit without spinlock debugging. Magazines are not
+ * cache line aligned: only the drains touch another cpu's magazines, so
+ * padding them would just waste per-cpu memory.
+ */
+#define ZS_MAG_SIZE	6
+
+/*
+ * Per-cpu, per-class magazine of objects released by zs_free(). The
+ * objects stay allocated in their zspage together with their handle, so
+ * the next zs_malloc() of the class on this cpu can hand them out again
+ * without taking class->lock, and migration treats them like any other
+ * allocated object. The lock is only ever contended by the drains.
+ */
+struct zs_magazine {
+	spinlock_t lock;
+	unsigned int count;
+	unsigned long hits;
+	unsigned long handles[ZS_MAG_SIZE];
+};
+
 /*
  * Placed within free objects to form a singly linked list.
  * For every zspage, zspage->freeobj gives head of this list.
@@ -247,6 +269,10 @@ struct zs_pool {
 	const char *name;
 
 	struct size_class **size_class;
+	/* zs_size_classes magazines per cpu, indexed by class->index */
+	struct zs_magazine __percpu *magazines;
+	/* drains the magazines of cpus going offline */
+	struct notifier_block mag_cpu_nb;
 	struct kmem_cache *handle_cachep;
 	struct kmem_cache *zspage_cachep;
 
@@ -605,6 +631,8 @@ static void __exit zs_stat_exit(void)
 }
 
 static unsigned long zs_can_compact(struct size_class *class);
+static void zs_mag_stats(struct zs_pool *pool, struct size_class *class,
+			unsigned long *cached, unsigned long *hits);
 
 static int zs_stats_size_show(struct seq_file *s, void *v)
 {
@@ -617,11 +645,13 @@ static int zs_stats_size_show(struct seq_file *s, void *v)
 	unsigned long total_class_almost_full = 0, total_class_almost_empty = 0;
 	unsigned long total_objs = 0, total_used_objs = 0, total_pages = 0;
 	unsigned long total_freeable = 0;
+	unsigned long cached, mag_hits;
+	unsigned long total_cached = 0, total_mag_hits = 0;
 
-	seq_printf(s, " %5s %5s %11s %12s %13s %10s %10s %16s %8s\n",
+	seq_printf(s, " %5s %5s %11s %12s %13s %10s %10s %16s %8s %8s %10s\n",
 			"class", "size", "almost_full", "almost_empty",
 			"obj_allocated", "obj_used", "pages_used",
-			"pages_per_zspage", "freeable");
+			"pages_per_zspage", "freeable", "cached", "mag_hits");
 
 	for (i = 0; i < zs_size_classes; i++) {
 		class = pool->size_class[i];
@@ -636,16 +666,17 @@ static int zs_stats_size_show(struct seq_file *s, void *v)
 		obj_used = zs_stat_get(class, OBJ_USED);
 		freeable = zs_can_compact(class);
 		spin_unlock(&class->lock);
+		zs_mag_stats(pool, class, &cached, &mag_hits);
 
 		objs_per_zspage = class->objs_per_zspage;
 		pages_used = obj_allocated / objs_per_zspage *
 				class->pages_per_zspage;
 
 		seq_printf(s, " %5u %5u %11lu %12lu %13lu"
-				" %10lu %10lu %16d %8lu\n",
+				" %10lu %10lu %16d %8lu %8lu %10lu\n",
 			i, class->size, class_almost_full, class_almost_empty,
 			obj_allocated, obj_used, pages_used,
-			class->pages_per_zspage, freeable);
+			class->pages_per_zspage, freeable, cached, mag_hits);
 
 		total_class_almost_full += class_almost_full;
 		total_class_almost_empty += class_almost_empty;
@@ -653,13 +684,16 @@ static int zs_stats_size_show(struct seq_file *s, void *v)
 		total_used_objs += obj_used;
 		total_pages += pages_used;
 		total_freeable += freeable;
+		total_cached += cached;
+		total_mag_hits += mag_hits;
 	}
 
 	seq_puts(s, "\n");
-	seq_printf(s, " %5s %5s %11lu %12lu %13lu %10lu %10lu %16s %8lu\n",
+	seq_printf(s, " %5s %5s %11lu %12lu %13lu %10lu %10lu %16s %8lu %8lu %10lu\n",
 			"Total", "", total_class_almost_full,
 			total_class_almost_empty, total_objs,
-			total_used_objs, total_pages, "", total_freeable);
+			total_used_objs, total_pages, "", total_freeable,
+			total_cached, total_mag_hits);
 
 	return 0;
 }
@@ -1512,6 +1546,80 @@ size_t zs_huge_class_size(struct zs_pool *pool)
 }
 EXPORT_SYMBOL_GPL(zs_huge_class_size);
 
+static unsigned long zs_mag_alloc(struct zs_pool *pool,
+				struct size_class *class)
+{
+	struct zs_magazine *mag;
+	unsigned long handle = 0;
+
+	mag = get_cpu_ptr(pool->magazines) + class->index;
+	spin_lock(&mag->lock);
+	if (mag->count) {
+		handle = mag->handles[--mag->count];
+		mag->hits++;
+	}
+	spin_unlock(&mag->lock);
+	put_cpu_ptr(pool->magazines);
+
+	return handle;
+}
+
+static bool zs_mag_free(struct zs_pool *pool, struct size_class *class,
+			unsigned long handle)
+{
+	struct zs_magazine *mag;
+	bool cached = false;
+
+	/* Keeping a whole zspage around for one object isn't worth it */
+	if (class->objs_per_zspage == 1)
+		return false;
+
+	mag = get_cpu_ptr(pool->magazines) + class->index;
+	spin_lock(&mag->lock);
+	if (mag->count < ZS_MAG_SIZE) {
+		mag->handles[mag->count++] = handle;
+		cached = true;
+	}
+	spin_unlock(&mag->lock);
+	put_cpu_ptr(pool->magazines);
+
+	return cached;
+}
+
+static void zs_mag_stats(struct zs_pool *pool, struct size_class *class,
+			unsigned long *cached, unsigned long *hits)
+{
+	struct zs_magazine *mag;
+	int cpu;
+
+	*cached = *hits = 0;
+	for_each_possible_cpu(cpu) {
+		mag = per_cpu_ptr(pool->magazines, cpu) + class->index;
+		*cached += READ_ONCE(mag->count);
+		*hits += READ_ONCE(mag->hits);
+	}
+}
+
+static int zs_mag_init(struct zs_pool *pool)
+{
+	struct zs_magazine *mags;
+	int cpu, i;
+
+	pool->magazines = __alloc_percpu(
+			sizeof(struct zs_magazine) * zs_size_classes,
+			__alignof__(struct zs_magazine));
+	if (!pool->magazines)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		mags = per_cpu_ptr(pool->magazines, cpu);
+		for (i = 0; i < zs_size_classes; i++)
+			spin_lock_init(&mags[i].lock);
+	}
+
+	return 0;
+}
+
 static unsigned long obj_malloc(struct size_class *class,
 				struct zspage *zspage, unsigned long handle)
 {
@@ -1574,14 +1682,18 @@ unsigned long zs_malloc(struct zs_pool *pool, size_t size, gfp_t gfp)
 	if (unlikely(!size || size > ZS_MAX_ALLOC_SIZE))
 		return 0;
 
-	handle = cache_alloc_handle(pool, gfp);
-	if (!handle)
-		return 0;
-
 	/* extra space in chunk to keep the handle */
 	size += ZS_HANDLE_SIZE;
 	class = pool->size_class[get_size_class_index(size)];
 
+	handle = zs_mag_alloc(pool, class);
+	if (handle)
+		return handle;
+
+	handle = cache_alloc_handle(pool, gfp);
+	if (!handle)
+		return 0;
+
 	spin_lock(&class->lock);
 	zspage = find_get_zspage(class);
 	if (likely(zspage)) {
@@ -1645,7 +1757,8 @@ static void obj_free(struct size_class *class, unsigned long obj)
 	zs_stat_dec(class, OBJ_USED, 1);
 }
 
-void zs_free(struct zs_pool *pool, unsigned long handle)
+static void __zs_free(struct zs_pool *pool, unsigned long handle,
+			bool cache)
 {
 	struct zspage *zspage;
 	struct page *f_page;
@@ -1656,9 +1769,6 @@ void zs_free(struct zs_pool *pool, unsigned long handle)
 	enum fullness_group fullness;
 	bool isolated;
 
-	if (unlikely(!handle))
-		return;
-
 	pin_tag(handle);
 	obj = handle_to_obj(handle);
 	obj_to_location(obj, &f_page, &f_objidx);
@@ -1669,6 +1779,12 @@ void zs_free(struct zs_pool *pool, unsigned long handle)
 	get_zspage_mapping(zspage, &class_idx, &fullness);
 	class = pool->size_class[class_idx];
 
+	if (cache && zs_mag_free(pool, class, handle)) {
+		migrate_read_unlock(zspage);
+		unpin_tag(handle);
+		return;
+	}
+
 	spin_lock(&class->lock);
 	obj_free(class, obj);
 	fullness = fix_fullness_group(class, zspage);
@@ -1688,8 +1804,73 @@ void zs_free(struct zs_pool *pool, unsigned long handle)
 	unpin_tag(handle);
 	cache_free_handle(pool, handle);
 }
+
+void zs_free(struct zs_pool *pool, unsigned long handle)
+{
+	if (unlikely(!handle))
+		return;
+
+	__zs_free(pool, handle, true);
+}
 EXPORT_SYMBOL_GPL(zs_free);
 
+static void zs_mag_drain_cpu(struct zs_pool *pool, struct size_class *class,
+				int cpu)
+{
+	unsigned long handles[ZS_MAG_SIZE];
+	struct zs_magazine *mag;
+	unsigned int i, count;
+
+	mag = per_cpu_ptr(pool->magazines, cpu) + class->index;
+
+	spin_lock(&mag->lock);
+	count = mag->count;
+	memcpy(handles, mag->handles, count * sizeof(handles[0]));
+	mag->count = 0;
+	spin_unlock(&mag->lock);
+
+	for (i = 0; i < count; i++)
+		__zs_free(pool, handles[i], false);
+}
+
+/*
+ * Release the objects cached in every cpu's magazine for @class back to
+ * their zspages, so that compaction and pool teardown see them as free.
+ */
+static void zs_mag_drain(struct zs_pool *pool, struct size_class *class)
+{
+	int cpu;
+
+	if (!pool->magazines)
+		return;
+
+	for_each_possible_cpu(cpu)
+		zs_mag_drain_cpu(pool, class, cpu);
+}
+
+/*
+ * A dead cpu no longer allocates from its magazines, so give their
+ * objects back instead of leaving them cached until the next compaction.
+ */
+static int zs_mag_cpu_notifier(struct notifier_block *nb,
+				unsigned long action, void *pcpu)
+{
+	struct zs_pool *pool = container_of(nb, struct zs_pool, mag_cpu_nb);
+	int i, cpu = (long)pcpu;
+
+	if ((action & ~CPU_TASKS_FROZEN) != CPU_DEAD)
+		return NOTIFY_OK;
+
+	for (i = 0; i < zs_size_classes; i++) {
+		struct size_class *class = pool->size_class[i];
+
+		if (class->index == i)
+			zs_mag_drain_cpu(pool, class, cpu);
+	}
+
+	return NOTIFY_OK;
+}
+
 static void zs_object_copy(struct size_class *class, unsigned long dst,
 				unsigned long src)
 {
@@ -2358,6 +2539,9 @@ static void __zs_compact(struct zs_pool *pool, struct size_class *class)
 	struct zspage *src_zspage;
 	struct zspage *dst_zspage = NULL;
 
+	/* Cached objects would pin their zspages, give them back first */
+	zs_mag_drain(pool, class);
+
 	spin_lock(&class->lock);
 	while ((src_zspage = isolate_zspage(class, true))) {
 
@@ -2447,6 +2631,7 @@ static unsigned long zs_shrinker_count(struct shrinker *shrinker,
 	int i;
 	struct size_class *class;
 	unsigned long pages_to_free = 0;
+	unsigned long cached, hits;
 	struct zs_pool *pool = container_of(shrinker, struct zs_pool,
 			shrinker);
 
@@ -2458,6 +2643,10 @@ static unsigned long zs_shrinker_count(struct shrinker *shrinker,
 			continue;
 
 		pages_to_free += zs_can_compact(class);
+		/* magazines are drained by compaction */
+		zs_mag_stats(pool, class, &cached, &hits);
+		pages_to_free += cached / class->objs_per_zspage *
+				class->pages_per_zspage;
 	}
 
 	return pages_to_free;
@@ -2591,6 +2780,12 @@ struct zs_pool *zs_create_pool(const char *name)
 		prev_class = class;
 	}
 
+	if (zs_mag_init(pool))
+		goto err;
+
+	pool->mag_cpu_nb.notifier_call = zs_mag_cpu_notifier;
+	register_cpu_notifier(&pool->mag_cpu_nb);
+
 	/* debug only, don't abort if it fails */
 	zs_pool_stat_create(pool, name);
 
@@ -2616,6 +2811,17 @@ void zs_destroy_pool(struct zs_pool *pool)
 	int i;
 
 	zs_unregister_shrinker(pool);
+
+	if (pool->mag_cpu_nb.notifier_call)
+		unregister_cpu_notifier(&pool->mag_cpu_nb);
+
+	for (i = 0; i < zs_size_classes; i++) {
+		struct size_class *class = pool->size_class[i];
+
+		if (class && class->index == i)
+			zs_mag_drain(pool, class);
+	}
+
 	zs_unregister_migration(pool);
 	zs_pool_stat_destroy(pool);
 
@@ -2638,6 +2844,7 @@ void zs_destroy_pool(struct zs_pool *pool)
 		kfree(class);
 	}
 
+	free_percpu(pool->magazines);
 	destroy_cache(pool);
 	kfree(pool->size_class);
 	kfree(pool->name);
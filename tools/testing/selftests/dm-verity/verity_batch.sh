@@ -0,0 +1,59 @@
+#!/bin/sh
+# Checks that a corrupted data block corrected by FEC while queued for
+# batched hashing doesn't break verification of a following data block
+# that is split across pages and hashed on its own.
+
+NAME=verity-batch-test
+BS=4096
+TMP=$(mktemp -d)
+
+cleanup()
+{
+	rmmod test_dm_verity 2> /dev/null
+	veritysetup close $NAME 2> /dev/null
+	rm -rf "$TMP"
+}
+trap cleanup EXIT
+
+if [ "$(id -u)" -ne 0 ]; then
+	echo "verity_batch: must be run as root [SKIP]"
+	exit 0
+fi
+
+if ! which veritysetup > /dev/null 2>&1; then
+	echo "verity_batch: veritysetup not found [SKIP]"
+	exit 0
+fi
+
+if ! modprobe -q -n test_dm_verity; then
+	echo "verity_batch: test_dm_verity module not found [SKIP]"
+	exit 0
+fi
+
+# 16 data blocks of a fixed pattern, so a single changed byte is corruption
+head -c $((16 * BS)) /dev/zero | tr '\000' 'Z' > "$TMP/data"
+
+ROOT=$(veritysetup format --data-block-size=$BS --hash-block-size=$BS \
+	--fec-device="$TMP/fec" "$TMP/data" "$TMP/hash" |
+	sed -n 's/^Root hash:[[:space:]]*//p')
+if [ -z "$ROOT" ]; then
+	echo "verity_batch: veritysetup format failed [FAIL]"
+	exit 1
+fi
+
+# corrupt one byte of block 0; FEC can correct it
+printf 'x' | dd of="$TMP/data" bs=1 seek=100 conv=notrunc 2> /dev/null
+
+if ! veritysetup open --fec-device="$TMP/fec" "$TMP/data" $NAME \
+	"$TMP/hash" $ROOT; then
+	echo "verity_batch: veritysetup open failed [FAIL]"
+	exit 1
+fi
+
+if ! modprobe test_dm_verity dev=/dev/mapper/$NAME; then
+	echo "verity_batch: split block after corrected block [FAIL]"
+	exit 1
+fi
+
+echo "verity_batch: split block after corrected block [PASS]"
+exit 0
@@ -0,0 +1,303 @@
+/*
+ * psi_trigger - check that a cgroup memory pressure trigger fires in time
+ *
+ * Sets a "some" trigger on a test cgroup's memory.pressure, then has a
+ * child in that cgroup keep reading a file four times the size of the
+ * cgroup's memory.max, so that it stalls on reclaim and refaults. While
+ * waiting for the notification, the cgroup's stall total is sampled. The
+ * notification has to arrive within one trigger window of the sampled
+ * stall first reaching the threshold within a window.
+ *
+ * Needs root, cgroup2 with the memory controller, and a current directory
+ * on a disk-backed filesystem: without swap, file cache on tmpfs can't be
+ * reclaimed and the child would be OOM killed instead of stalling.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../kselftest.h"
+
+#define THRESHOLD_US	10000		/* 10ms of stall ... */
+#define WINDOW_US	100000		/* ... within 100ms, the minimum */
+#define MEM_MAX		(32 << 20)
+#define FILE_SIZE	(4 * MEM_MAX)
+#define SAMPLE_MS	5
+#define TIMEOUT_MS	20000
+#define MAX_SAMPLES	(TIMEOUT_MS / SAMPLE_MS + 1)
+
+static const char *data_file = "psi_trigger.data";
+static char cgroup_root[PATH_MAX];
+static char cgroup_dir[PATH_MAX];
+static int cgroup_mounted;
+
+static unsigned long long samples_us[MAX_SAMPLES];
+static unsigned long long samples_total[MAX_SAMPLES];
+
+static unsigned long long now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static int write_file(const char *dir, const char *name, const char *val)
+{
+	char path[PATH_MAX];
+	ssize_t len = strlen(val);
+	int fd, ret;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	fd = open(path, O_WRONLY);
+	if (fd < 0)
+		return -1;
+	ret = write(fd, val, len) == len ? 0 : -1;
+	close(fd);
+	return ret;
+}
+
+static int find_cgroup2(void)
+{
+	char dev[256], dir[PATH_MAX], type[64];
+	FILE *f;
+
+	f = fopen("/proc/mounts", "r");
+	if (f) {
+		while (fscanf(f, "%255s %4095s %63s %*[^\n]",
+			      dev, dir, type) == 3) {
+			if (!strcmp(type, "cgroup2")) {
+				strcpy(cgroup_root, dir);
+				fclose(f);
+				return 0;
+			}
+		}
+		fclose(f);
+	}
+
+	strcpy(cgroup_root, "/tmp/psi_trigger_cg.XXXXXX");
+	if (!mkdtemp(cgroup_root))
+		return -1;
+	if (mount("none", cgroup_root, "cgroup2", 0, NULL)) {
+		rmdir(cgroup_root);
+		return -1;
+	}
+	cgroup_mounted = 1;
+	return 0;
+}
+
+static void cleanup(void)
+{
+	if (cgroup_dir[0])
+		rmdir(cgroup_dir);
+	if (cgroup_mounted) {
+		umount(cgroup_root);
+		rmdir(cgroup_root);
+	}
+	unlink(data_file);
+}
+
+/* Write the data file and drop it from the page cache */
+static int create_data_file(void)
+{
+	static char buf[1 << 16];
+	int fd, i;
+
+	memset(buf, 0x5a, sizeof(buf));
+	fd = open(data_file, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0)
+		return -1;
+	for (i = 0; i < FILE_SIZE / (int)sizeof(buf); i++) {
+		if (write(fd, buf, sizeof(buf)) != sizeof(buf)) {
+			close(fd);
+			return -1;
+		}
+	}
+	fsync(fd);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	close(fd);
+	return 0;
+}
+
+static void stream_file(void)
+{
+	static char buf[1 << 16];
+	char pid[32];
+	int fd;
+
+	snprintf(pid, sizeof(pid), "%d", getpid());
+	if (write_file(cgroup_dir, "cgroup.procs", pid))
+		_exit(1);
+
+	for (;;) {
+		fd = open(data_file, O_RDONLY);
+		if (fd < 0)
+			_exit(1);
+		while (read(fd, buf, sizeof(buf)) > 0)
+			;
+		close(fd);
+	}
+}
+
+static int read_some_total(int fd, unsigned long long *total)
+{
+	char buf[256], *p;
+	ssize_t n;
+
+	n = pread(fd, buf, sizeof(buf) - 1, 0);
+	if (n <= 0)
+		return -1;
+	buf[n] = '\0';
+
+	p = strstr(buf, "total=");
+	if (strncmp(buf, "some", 4) || !p)
+		return -1;
+	*total = strtoull(p + strlen("total="), NULL, 10);
+	return 0;
+}
+
+int main(void)
+{
+	unsigned long long start, t, total, thresh_us = 0, event_us = 0;
+	char trigger[64], path[PATH_MAX];
+	int trig_fd, stat_fd, nr = 0, first = 0, ret;
+	struct pollfd pfd;
+	pid_t child;
+
+	if (getuid()) {
+		printf("psi_trigger: must be run as root\n");
+		return ksft_exit_skip();
+	}
+
+	if (find_cgroup2()) {
+		printf("psi_trigger: no cgroup2 hierarchy\n");
+		return ksft_exit_skip();
+	}
+
+	write_file(cgroup_root, "cgroup.subtree_control", "+memory");
+	snprintf(cgroup_dir, sizeof(cgroup_dir), "%s/psi_trigger.%d",
+		 cgroup_root, getpid());
+	if (mkdir(cgroup_dir, 0755)) {
+		cgroup_dir[0] = '\0';
+		cleanup();
+		printf("psi_trigger: can't create test cgroup\n");
+		return ksft_exit_skip();
+	}
+
+	snprintf(trigger, sizeof(trigger), "%d", MEM_MAX);
+	if (write_file(cgroup_dir, "memory.max", trigger)) {
+		cleanup();
+		printf("psi_trigger: no memory controller\n");
+		return ksft_exit_skip();
+	}
+
+	snprintf(path, sizeof(path), "%s/memory.pressure", cgroup_dir);
+	trig_fd = open(path, O_RDWR | O_NONBLOCK);
+	stat_fd = open(path, O_RDONLY);
+	if (trig_fd < 0 || stat_fd < 0) {
+		cleanup();
+		printf("psi_trigger: no memory.pressure, is CONFIG_PSI on?\n");
+		return ksft_exit_skip();
+	}
+
+	snprintf(trigger, sizeof(trigger), "some %d %d",
+		 THRESHOLD_US, WINDOW_US);
+	if (write(trig_fd, trigger, strlen(trigger) + 1) < 0) {
+		ret = errno;
+		close(trig_fd);
+		close(stat_fd);
+		cleanup();
+		printf("psi_trigger: setting trigger failed: %s\n",
+		       strerror(ret));
+		return ret == EOPNOTSUPP ? ksft_exit_skip() : ksft_exit_fail();
+	}
+
+	if (create_data_file()) {
+		close(trig_fd);
+		close(stat_fd);
+		cleanup();
+		printf("psi_trigger: can't write %s\n", data_file);
+		return ksft_exit_skip();
+	}
+
+	child = fork();
+	if (child < 0) {
+		close(trig_fd);
+		close(stat_fd);
+		cleanup();
+		return ksft_exit_fail();
+	}
+	if (!child)
+		stream_file();
+
+	pfd.fd = trig_fd;
+	pfd.events = POLLPRI;
+	start = now_us();
+
+	while (nr < MAX_SAMPLES) {
+		ret = poll(&pfd, 1, SAMPLE_MS);
+		t = now_us();
+		if (ret < 0 && errno != EINTR)
+			break;
+		if (ret > 0) {
+			if (!(pfd.revents & POLLPRI))
+				break;
+			event_us = t;
+			break;
+		}
+
+		if (read_some_total(stat_fd, &total))
+			break;
+		samples_us[nr] = t;
+		samples_total[nr] = total;
+
+		/* stall growth over the last window, as the trigger sees it */
+		while (samples_us[first] + WINDOW_US < t)
+			first++;
+		if (!thresh_us &&
+		    total - samples_total[first] >= THRESHOLD_US)
+			thresh_us = t;
+		nr++;
+
+		if (t - start > TIMEOUT_MS * 1000ULL)
+			break;
+	}
+
+	kill(child, SIGKILL);
+	waitpid(child, NULL, 0);
+	close(trig_fd);
+	close(stat_fd);
+	cleanup();
+
+	if (!event_us) {
+		if (!thresh_us) {
+			printf("psi_trigger: not enough memory pressure\n");
+			return ksft_exit_skip();
+		}
+		printf("psi_trigger: no notification %llums after the threshold was reached\n",
+		       (now_us() - thresh_us) / 1000);
+		return ksft_exit_fail();
+	}
+
+	if (thresh_us && event_us - thresh_us > WINDOW_US) {
+		printf("psi_trigger: notification %llums after the threshold was reached, window is %dms\n",
+		       (event_us - thresh_us) / 1000, WINDOW_US / 1000);
+		return ksft_exit_fail();
+	}
+
+	printf("psi_trigger: notified %llums after the start\n",
+	       (event_us - start) / 1000);
+	return ksft_exit_pass();
+}